@@ -1,8 +1,28 @@
 TEMPLATE = subdirs
 
-SUBDIRS = game editor
+SUBDIRS = core game editor bench gridbench patrolbench levelsolver mjreplay mjfuzz mjlevelgen levelc mjpack
+core.file = src/core.pro
 game.file = src/game.pro
 editor.file = src/editor.pro
+bench.file = src/bench.pro
+gridbench.file = src/gridbench.pro
+patrolbench.file = src/patrolbench.pro
+levelsolver.file = src/levelsolver.pro
+mjreplay.file = src/mjreplay.pro
+mjfuzz.file = src/mjfuzz.pro
+mjlevelgen.file = src/mjlevelgen.pro
+levelc.file = src/levelc.pro
+mjpack.file = src/mjpack.pro
+game.depends = core
+editor.depends = core
+bench.depends = core
+gridbench.depends = core
+patrolbench.depends = core
+levelsolver.depends = core
+mjreplay.depends = core
+mjlevelgen.depends = core
+levelc.depends = core
+mjpack.depends = core
 
 OTHER_FILES += levels/* \
     pics/* \
@@ -0,0 +1,37 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <stdint.h>
+
+//the game and the editor look for this in the folder they run from, mjpack writes it
+#define ASSETPACK_NAME "bakingquest.mjp"
+#define ASSETPACK_MAGIC "MJPK"
+#define ASSETPACK_VERSION ( 1 )
+//every entry starts on this, so a stored one can be used where it lies in the mapped pack
+#define ASSETPACK_ALIGN ( 16 )
+
+//the entry was written with qCompress and has to go through qUncompress
+#define ASSETPACK_COMPRESSED ( 1 )
+
+/* the pack starts with this, the entries follow it and the index and the names come last. Little endian */
+struct assetPackHeader{
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t namesBytes;
+    uint64_t indexOffset;     //count assetPackEntry
+    uint64_t namesOffset;     //the names one after the other, not 0 terminated
+};
+
+/* one file in the pack, by the path it has in the game's folder like levels/levelone.txt or sprites/MJ_left.png */
+struct assetPackEntry{
+    uint32_t name;            //offset into the names
+    uint32_t nameLength;
+    uint64_t offset;
+    uint64_t storedSize;      //the bytes in the pack
+    uint64_t size;            //the bytes once uncompressed
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+#endif // ASSETPACK_H
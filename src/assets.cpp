@@ -0,0 +1,188 @@
+/*! \abstract assetStore
+ *         Everything the game and the editor load from disk goes through here. With a pack built by mjpack next to
+ *         the game, startup and level changes read from one mapped file instead of opening a level and dozens of
+ *         pngs each: stored entries are used where they lie, compressed ones are unpacked with qUncompress. Names
+ *         that aren't in the pack, or everything when there is no pack, come from the folders like they always did.
+ */
+
+#include "assets.h"
+#include <QBuffer>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+//the QBuffer a packed sound plays from, found again by name so the next sound can free it
+#define ASSET_STREAM "assetStream"
+
+assetStore::assetStore(){
+    base = NULL;
+    entries = NULL;
+}
+
+assetStore::assetStore(const QString &packName){
+    base = NULL;
+    entries = NULL;
+    openPack(packName);
+}
+
+//the key a name is looked up by, "./sprites//a.png" is "sprites/a.png"
+static QString assetKey(const QString &name){
+    QString key = QDir::cleanPath(name);
+    if(key.startsWith("./"))
+        key = key.mid(2);
+    return key;
+}
+
+/*! \brief assetStore::openPack
+ *  maps the pack and checks its index once, a pack that doesn't check out is not used at all
+ */
+bool assetStore::openPack(const QString &fileName){
+    pack.setFileName(fileName);
+    if(!pack.open(QIODevice::ReadOnly))
+        return false;
+    qint64 packSize = pack.size();
+    const uchar *data = pack.map(0, packSize);
+    if(data == NULL){
+        std::cout << fileName.toStdString() << ": can not map\n";
+        pack.close();
+        return false;
+    }
+
+    const assetPackHeader *header = (const assetPackHeader*)data;
+    QString error;
+    if(packSize < (qint64)sizeof(assetPackHeader) || memcmp(header->magic, ASSETPACK_MAGIC, 4) != 0)
+        error = "not an asset pack";
+    else if(header->version != ASSETPACK_VERSION)
+        error = QString("pack version %1, this build reads %2").arg(header->version).arg(ASSETPACK_VERSION);
+    //sizes are compared with what is left after an offset, so a crafted offset can't wrap around
+    else if(header->indexOffset % 8 != 0 || header->indexOffset > (quint64)packSize ||
+            (quint64)header->count > ((quint64)packSize - header->indexOffset)/sizeof(assetPackEntry) ||
+            header->namesOffset > (quint64)packSize || header->namesBytes > (quint64)packSize - header->namesOffset)
+        error = "truncated";
+
+    const assetPackEntry *list = (const assetPackEntry*)(data + (error.isEmpty() ? header->indexOffset : 0));
+    const char *names = error.isEmpty() ? (const char*)data + header->namesOffset : NULL;
+    QHash<QString, int> found;
+    for(uint32_t e = 0; error.isEmpty() && e < header->count; e++){
+        const assetPackEntry &entry = list[e];
+        if((quint64)entry.name + entry.nameLength > header->namesBytes || entry.offset % ASSETPACK_ALIGN != 0 ||
+           entry.offset > (quint64)packSize || entry.storedSize > (quint64)packSize - entry.offset ||
+           entry.storedSize > INT_MAX || entry.size > INT_MAX ||
+           ((entry.flags & ASSETPACK_COMPRESSED) == 0 && entry.storedSize != entry.size))
+            error = QString("bad entry %1").arg(e);
+        else
+            found.insert(QString::fromUtf8(names + entry.name, entry.nameLength), e);
+    }
+    if(!error.isEmpty()){
+        std::cout << fileName.toStdString() << ": " << error.toStdString() << ", using the loose files\n";
+        pack.unmap((uchar*)data);
+        pack.close();
+        return false;
+    }
+
+    base = data;
+    entries = list;
+    index.swap(found);
+    return true;
+}
+
+const assetPackEntry *assetStore::find(const QString &name) const{
+    if(base == NULL)
+        return NULL;
+    QHash<QString, int>::const_iterator it = index.constFind(assetKey(name));
+    return it == index.constEnd() ? NULL : &entries[it.value()];
+}
+
+bool assetStore::contains(const QString &name) const{
+    return find(name) != NULL;
+}
+
+bool assetStore::packed(const QString &name, QByteArray &bytes) const{
+    const assetPackEntry *entry = find(name);
+    if(entry == NULL)
+        return false;
+    const char *data = (const char*)base + entry->offset;
+    if(entry->flags & ASSETPACK_COMPRESSED){
+        bytes = qUncompress((const uchar*)data, (int)entry->storedSize);
+        return (quint64)bytes.size() == entry->size;
+    }
+    bytes = QByteArray::fromRawData(data, (int)entry->size);
+    return true;
+}
+
+QByteArray assetStore::read(const QString &name) const{
+    QByteArray bytes;
+    if(packed(name, bytes))
+        return bytes;
+    QFile file(name);
+    if(file.open(QIODevice::ReadOnly))
+        bytes = file.readAll();
+    return bytes;
+}
+
+/*! \brief assetStore::list
+ *  what is directly in folder, sorted, like QDir::entryList gives it
+ */
+QStringList assetStore::list(const QString &folder, const QString &suffix) const{
+    QString prefix = assetKey(folder) + "/";
+    QSet<QString> seen;
+    QStringList names;
+    for(QHash<QString, int>::const_iterator it = index.constBegin(); it != index.constEnd(); ++it){
+        QString rest = it.key().mid(prefix.size());
+        if(it.key().startsWith(prefix) && !rest.contains('/') && rest.endsWith(suffix) && !seen.contains(rest)){
+            seen.insert(rest);
+            names.append(rest);
+        }
+    }
+    QStringList loose = QDir(folder).entryList(QStringList("*" + suffix), QDir::Files);
+    for(int i = 0; i < loose.size(); i++){
+        if(!seen.contains(loose.at(i))){
+            seen.insert(loose.at(i));
+            names.append(loose.at(i));
+        }
+    }
+    names.sort();
+    return names;
+}
+
+QPixmap assetStore::pixmap(const QString &name) const{
+    QByteArray bytes;
+    QPixmap picture;
+    if(packed(name, bytes))
+        picture.loadFromData(bytes);
+    else
+        picture.load(name);
+    return picture;
+}
+
+QImage assetStore::image(const QString &name) const{
+    QByteArray bytes;
+    QImage picture;
+    if(packed(name, bytes))
+        picture.loadFromData(bytes);
+    else
+        picture.load(name);
+    return picture;
+}
+
+void assetStore::setMedia(QMediaPlayer *player, const QString &name) const{
+    QBuffer *old = player->findChild<QBuffer*>(ASSET_STREAM);
+    QByteArray bytes;
+    if(packed(name, bytes)){
+        //the name is only there so the backend can tell what kind of sound it is
+        QBuffer *stream = new QBuffer(player);
+        stream->setObjectName(ASSET_STREAM);
+        stream->setData(bytes);
+        stream->open(QIODevice::ReadOnly);
+        player->setMedia(QMediaContent(QUrl::fromLocalFile(name)), stream);
+    }
+    else
+        player->setMedia(QUrl::fromLocalFile(QFileInfo(name).absoluteFilePath()));
+    delete old;
+}
+
+assetStore &assets(){
+    //made the first time it is asked for, which is safe from any thread
+    static assetStore store(ASSETPACK_NAME);
+    return store;
+}
@@ -0,0 +1,46 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include <QtCore>
+#include <QtGui>
+#include <QMediaPlayer>
+#include "assetpack.h"
+
+/* where levels, sprites and sounds come from. Names are paths in the game's folder, like levels/levelone.txt. A name
+   that is in the pack is read from the mapped pack, anything else from the folder like before, so a game without
+   a pack runs from the loose files. The pack is opened once and never changes, so reading is safe from any thread */
+class assetStore
+{
+public:
+    assetStore();
+    explicit assetStore(const QString &packName);
+
+    bool openPack(const QString &fileName);
+
+    bool contains(const QString &name) const;
+    //the bytes of a packed asset, stored ones point into the mapped pack and are not copied
+    bool packed(const QString &name, QByteArray &bytes) const;
+    //from the pack or from the folder, empty if it is in neither
+    QByteArray read(const QString &name) const;
+    //file names in a folder that end with suffix, from the pack and from the disk
+    QStringList list(const QString &folder, const QString &suffix) const;
+
+    QPixmap pixmap(const QString &name) const;
+    //the same as a QImage, which unlike a QPixmap can be made off the gui thread
+    QImage image(const QString &name) const;
+    //plays a packed sound from memory, a loose one from its file
+    void setMedia(QMediaPlayer *player, const QString &name) const;
+
+private:
+    QFile pack;
+    const uchar *base;
+    const assetPackEntry *entries;
+    QHash<QString, int> index;
+
+    const assetPackEntry *find(const QString &name) const;
+};
+
+//the one the game and the editor read through, it opens ASSETPACK_NAME the first time it is asked for
+assetStore &assets();
+
+#endif // ASSETS_H
@@ -0,0 +1,289 @@
+/*! \abstract bench
+ *         Times the level paths and the game rules on the bundled levels and on big generated ones, so a change that makes
+ *         them slower shows up. Every benchmark runs a few untimed warmups first, then is timed over a number of samples,
+ *         and prints the minimum, median, 90th and 99th percentile, maximum and mean of the time one call takes. -o writes
+ *         the same as JSON, for keeping results from one build to compare with the next.
+ *
+ *         It runs on the core the engine drives, without the window: readFile is levelFile::read, LoadMap reads the level
+ *         and fills the simulation the way engine::LoadMap does, reset is a restart through headlessGame, the moves and
+ *         checks are the simulation calls the engine makes and createFile is levelFile::write.
+ *
+ *         bench [-w warmups] [-r samples] [-R samples for loading and saving] [-s WxH]... [-o file.json] [level...]
+ *
+ *         Run it from the game's folder, the levels name each other by paths like levels/levelone.txt.
+ */
+
+#include "headlessgame.h"
+#include "levelgen.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+struct benchStats{
+    std::string name;
+    std::string level;
+    int samples;
+    int batch;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+    double mean;
+};
+
+static int warmups = 10;
+static int samples = 200;
+static int heavySamples = 30;
+static std::vector<benchStats> results;
+
+static double percentile(const std::vector<double> &sorted, double p){
+    //nearest rank
+    int rank = (int)ceil(p/100.0*sorted.size());
+    rank = std::max(1, std::min(rank, (int)sorted.size()));
+    return sorted[rank - 1];
+}
+
+/*! \brief measure
+ *  runs setup untimed before every sample, then times batch calls of op. A sample is the time of one call in nanoseconds
+ */
+static void measure(const std::string &name, const std::string &level, int count, int batch,
+                    const std::function<void()> &setup, const std::function<void()> &op){
+    for(int w = 0; w < warmups; w++){
+        setup();
+        for(int b = 0; b < batch; b++)
+            op();
+    }
+
+    std::vector<double> times;
+    times.reserve(count);
+    for(int s = 0; s < count; s++){
+        setup();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int b = 0; b < batch; b++)
+            op();
+        times.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count()/batch);
+    }
+    std::sort(times.begin(), times.end());
+
+    benchStats stats;
+    stats.name = name;
+    stats.level = level;
+    stats.samples = count;
+    stats.batch = batch;
+    stats.min = times.front();
+    stats.p50 = percentile(times, 50);
+    stats.p90 = percentile(times, 90);
+    stats.p99 = percentile(times, 99);
+    stats.max = times.back();
+    stats.mean = 0;
+    for(unsigned int i = 0; i < times.size(); i++)
+        stats.mean += times[i];
+    stats.mean /= times.size();
+    results.push_back(stats);
+
+    printf("%-16s %-26s %12.0f %12.0f %12.0f %12.0f %12.0f\n", name.c_str(), level.c_str(), stats.min, stats.p50,
+           stats.p90, stats.p99, stats.max);
+    fflush(stdout);
+}
+
+/*! \brief writeLevel
+ *  a big generated level with an npc for every 16 cells of floor and a movable block for every 32, mj starts bottom left
+ *  with a movable block right in front of her. The files it wrote are added to written so they can be removed after
+ */
+static std::string writeLevel(int width, int height, std::vector<std::string> &written){
+    char name[64];
+    snprintf(name, sizeof(name), "bench-synthetic-%dx%d", width, height);
+    levelGenOptions options;
+    options.width = width;
+    options.height = height;
+    int floorCells = width*((height - 2)/options.floorGap + 1);
+    options.goods = floorCells/32;
+    options.enemies = floorCells/32;
+    options.mblocks = floorCells/32;
+
+    std::vector<std::string> files;
+    std::string error;
+    if(!generateLevels(options, name, files, error))
+        printf("%s\n", error.c_str());
+    written.insert(written.end(), files.begin(), files.end());
+    return name;
+}
+
+/*! \brief benchLevel
+ *  every benchmark on one level. Each one starts from the level freshly loaded, so npcs walked by one don't
+ *  walk into mj in the next
+ */
+static void benchLevel(const std::string &level){
+    std::string label = level.substr(level.find_last_of('/') + 1);
+    std::string error;
+    std::function<void()> nothing = [](){};
+
+    //levelFile::read, the text or the compiled level next to it
+    levelFile file;
+    measure("readFile", label, heavySamples, 1, [&](){
+        file = levelFile();
+    }, [&](){
+        file.read(level, error);
+    });
+    if(!error.empty()){
+        printf("%s\n", error.c_str());
+        return;
+    }
+
+    //engine::LoadMap: the level is read and put into a simulation that had the level before it
+    simulation sim;
+    gameRandom random;
+    measure("LoadMap", label, heavySamples, 1, nothing, [&](){
+        levelFile loaded;
+        loaded.read(level, error);
+        loaded.addTo(sim, true, random);
+    });
+
+    //engine::reset on the level that is up, a restart doesn't read the file again
+    headlessGame game(1);
+    game.load(level, error);
+    measure("reset", label, heavySamples, 1, nothing, [&](){
+        game.load(level, error);
+    });
+
+    //mj walking back and forth
+    int walk = 0;
+    file.addTo(sim, true, random);
+    measure("moveChar", label, samples, 64, nothing, [&](){
+        sim.clearEvents();
+        sim.moveChar((walk++ / 8) % 2 ? -1 : 1);
+    });
+
+    file.addTo(sim, true, random);
+    measure("moveEnemies", label, samples, 16, nothing, [&](){
+        sim.clearEvents();
+        sim.moveEnemies();
+    });
+    measure("moveGood", label, samples, 16, nothing, [&](){
+        sim.clearEvents();
+        sim.moveGood();
+    });
+
+    //turning on the spot asks for a collision check without moving anyone
+    file.addTo(sim, true, random);
+    measure("checkCollisions", label, samples, 1, [&](){
+        sim.moveChar(0);
+    }, [&](){
+        sim.clearEvents();
+        sim.checkCollisions();
+    });
+
+    //dropBlock needs a block to drop, levels where mj can't pick one up from where she starts are left out
+    file.addTo(sim, true, random);
+    //she faces left, front and right in turn, a turn doesn't move her
+    for(int turn = 0; turn < 3 && !sim.mjHasBlock(); turn++){
+        sim.moveChar(turn == 0 ? -1 : 1);
+        sim.getBlock();
+    }
+    if(sim.mjHasBlock()){
+        measure("dropBlock", label, samples, 1, [&](){
+            if(!sim.mjHasBlock())
+                sim.getBlock();
+        }, [&](){
+            sim.clearEvents();
+            sim.dropBlock();
+        });
+    }
+
+    //levelFile::write, to a file removed after
+    measure("createFile", label, heavySamples, 1, nothing, [&](){
+        file.write("bench.tmp", error);
+    });
+    remove("bench.tmp");
+}
+
+static void jsonString(FILE *out, const std::string &text){
+    fputc('"', out);
+    for(unsigned int i = 0; i < text.size(); i++){
+        unsigned char c = text[i];
+        if(c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if(c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static void writeJson(const std::string &fileName){
+    FILE *out = fopen(fileName.c_str(), "w");
+    if(out == NULL){
+        printf("%s: can not write\n", fileName.c_str());
+        return;
+    }
+    fprintf(out, "{\n    \"warmups\": %d,\n    \"benchmarks\": [", warmups);
+    for(unsigned int i = 0; i < results.size(); i++){
+        const benchStats &s = results[i];
+        fprintf(out, "%s\n        {\n            \"name\": ", i == 0 ? "" : ",");
+        jsonString(out, s.name);
+        fprintf(out, ",\n            \"level\": ");
+        jsonString(out, s.level);
+        fprintf(out, ",\n            \"unit\": \"ns\",\n            \"samples\": %d,\n            \"batch\": %d,\n"
+                     "            \"min\": %.1f,\n            \"p50\": %.1f,\n            \"p90\": %.1f,\n"
+                     "            \"p99\": %.1f,\n            \"max\": %.1f,\n            \"mean\": %.1f\n        }",
+                s.samples, s.batch, s.min, s.p50, s.p90, s.p99, s.max, s.mean);
+    }
+    fprintf(out, "\n    ]\n}\n");
+    fclose(out);
+}
+
+int main(int argc, char *argv[]){
+    std::vector<std::string> levels;
+    std::vector<std::pair<int, int> > sizes;
+    std::string jsonFile;
+    for(int a = 1; a < argc; a++){
+        if(strcmp(argv[a], "-w") == 0 && a + 1 < argc)
+            warmups = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-r") == 0 && a + 1 < argc)
+            samples = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-R") == 0 && a + 1 < argc)
+            heavySamples = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-o") == 0 && a + 1 < argc)
+            jsonFile = argv[++a];
+        else if(strcmp(argv[a], "-s") == 0 && a + 1 < argc){
+            int width, height;
+            if(sscanf(argv[++a], "%dx%d", &width, &height) == 2)
+                sizes.push_back(std::make_pair(width, height));
+        }
+        else
+            levels.push_back(argv[a]);
+    }
+    if(levels.empty()){
+        levels.push_back("levels/defaultlevel");
+        levels.push_back("levels/levelone.txt");
+        levels.push_back("levels/leveltwo.txt");
+        levels.push_back("levels/levelthree.txt");
+    }
+    if(sizes.empty()){
+        sizes.push_back(std::make_pair(256, 64));
+        sizes.push_back(std::make_pair(1024, 256));
+    }
+    warmups = std::max(0, warmups);
+    samples = std::max(1, samples);
+    heavySamples = std::max(1, heavySamples);
+
+    std::vector<std::string> written;
+    for(unsigned int s = 0; s < sizes.size(); s++)
+        levels.push_back(writeLevel(sizes[s].first, sizes[s].second, written));
+
+    printf("%-16s %-26s %12s %12s %12s %12s %12s\n", "ns per call", "level", "min", "p50", "p90", "p99", "max");
+    for(unsigned int l = 0; l < levels.size(); l++)
+        benchLevel(levels[l]);
+
+    for(unsigned int w = 0; w < written.size(); w++)
+        remove(written[w].c_str());
+    if(!jsonFile.empty())
+        writeJson(jsonFile);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#times the level read, load, restart and save paths and the game rules, with percentiles and JSON output, see bench.cpp
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(core.pri)
+
+SOURCES += \
+    bench.cpp
+
+TARGET = bench
@@ -0,0 +1,14 @@
+#link against the mjcore library built by core.pro
+CONFIG += c++11 thread
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+win32:CONFIG(release, debug|release): CORE_DIR = $$OUT_PWD/release
+else:win32:CONFIG(debug, debug|release): CORE_DIR = $$OUT_PWD/debug
+else: CORE_DIR = $$OUT_PWD
+
+LIBS += -L$$CORE_DIR -lmjcore
+
+win32-msvc*: PRE_TARGETDEPS += $$CORE_DIR/mjcore.lib
+else: PRE_TARGETDEPS += $$CORE_DIR/libmjcore.a
@@ -0,0 +1,31 @@
+#the game rules as plain data, no widgets or media so it can run headless
+TEMPLATE = lib
+CONFIG += staticlib c++11 thread
+CONFIG -= qt
+
+SOURCES = \
+    simulation.cpp \
+    workerpool.cpp \
+    levelfile.cpp \
+    levelscanner.cpp \
+    levelbinary.cpp \
+    solver.cpp \
+    replay.cpp \
+    headlessgame.cpp \
+    levelgen.cpp \
+    trace.cpp
+
+HEADERS += \
+    simulation.h \
+    workerpool.h \
+    levelfile.h \
+    levelscanner.h \
+    levelbinary.h \
+    solver.h \
+    gamerandom.h \
+    replay.h \
+    headlessgame.h \
+    levelgen.h \
+    trace.h
+
+TARGET = mjcore
@@ -2,5 +2,19 @@
 #define DEFINITIONS_H
 
 #define BLOCK_SIZE ( 30 )
+
+//TICK_MS and NPC_TICKS live in simulation.h so the headless replay steps like the window does
+
+//most steps run to catch up after a stall, the rest of the time is dropped
+#define MAX_CATCHUP_TICKS ( 5 )
+
+//the fixed part of a level is painted in squares of STATIC_CHUNK blocks, at most STATIC_CHUNK_CACHE are kept
+#define STATIC_CHUNK ( 16 )
+#define STATIC_CHUNK_CACHE ( 64 )
+
+//a step or key that takes longer than a tick writes the last TRACE_WINDOW_MS of the trace to traces/, at most one
+//file every TRACE_GAP_MS so a slow machine doesn't fill the disk
+#define TRACE_WINDOW_MS ( 3000 )
+#define TRACE_GAP_MS ( 10000 )
 #include <QMediaPlayer>
 #endif // DEFINITIONS_H
@@ -12,7 +12,7 @@ int main(int argc, char *argv[]){
 
     editWindow *mainWindow = new editWindow;
 
-    mainWindow->setWindowIcon(QIcon("sprites/mexican_man.png"));
+    mainWindow->setWindowIcon(QIcon(assets().pixmap("sprites/mexican_man.png")));
     mainWindow->setWindowTitle(QString("MJBQ Editor"));
 
     mainWindow->setCentralWidget( mainWindow->GetGraphicsView() );
@@ -4,23 +4,33 @@ QT += multimedia
 
 TEMPLATE = app
 
+include(core.pri)
+
 SOURCES = \
     objects.cpp \
+    spritecache.cpp \
+    assets.cpp \
     engine.cpp \
     objStructure.cpp \
     parser.cpp \
+    levelprefetch.cpp \
     editormainwindow.cpp \
     edit_main.cpp \
     graphicsvieweditor.cpp
 
 HEADERS += \
     objects.h \
+    spritecache.h \
+    assets.h \
+    assetpack.h \
     engine.h \
     objStructure.h \
     parser.h \
+    levelprefetch.h \
     editormainwindow.h \
     graphicsvieweditor.h \
-    definitions.h
+    definitions.h \
+    frameprofiler.h
 
 TARGET = MixMaster
 
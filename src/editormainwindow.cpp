@@ -34,8 +34,9 @@ editWindow::editWindow(QWidget *parent) :
     ginny->SetScene( graphicsScene );
     ginny->SetParentWindow( this );
 
-    graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    //levels can be bigger than the window
+    graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+    graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
 
     //borderless doesn't look good
     //this->setWindowFlags(Qt::FramelessWindowHint);
@@ -25,25 +25,27 @@
  *        (for the health bar) are to appear in the level.
  */
 engine::engine(){
-    goodGuys = new objStructure();
-    enemies = new objStructure();
-    blocks = new objStructure();
-    other = new objStructure();
-    doors = new objStructure();
+    //the lists turn sprite names into ids as objects are added
+    sprites = new spriteCache();
+    goodGuys = new objStructure(sprites);
+    enemies = new objStructure(sprites);
+    blocks = new objStructure(sprites);
+    other = new objStructure(sprites);
+    doors = new objStructure(sprites);
     parsley = new parser();
-    facing = 0;
-    prevFacing = 0;
+    sim = new simulation();
+    sSize = NULL;
+    //the patrol stays on this thread, simulation::setThreads is for levels far bigger than the ones the game ships
+    LoadPoses();
+    mj = -1;
     itemCount = 0;
     curItems = 0;
     mjHasBlock = false;
+    chunksX = 0;
+    chunksY = 0;
+    prefetch = NULL;
+    parentWindow = NULL;
     player = new QMediaPlayer;
-    safeToCheckEnemyCollision = true;
-    //initialize array that holds politers to walkable blocks
-    //useful for moving
-    for(int y = 0; y< 20; y++){
-        for(int x = 0; x<30; x++)
-            walkable[y][x] = NULL;
-    }
 
     for(int x = 0; x<5; x++)
         goodObj[x] = NULL;
@@ -57,13 +59,15 @@ engine::engine( QGraphicsScene *scene ){
 }
 
 engine::~engine(){
+    delete prefetch;
     delete sSize;
     delete uiScene;
     delete goodGuys;
     delete enemies;
     delete blocks;
     delete other;
-    delete walkable;
+    delete sim;
+    delete sprites;
     delete parsley;
 }
 
@@ -83,7 +87,7 @@ void engine::SetScene(QGraphicsScene *scene){
  *         object.
  */
 void engine::AddSprite(const char* spriteFName, int xLoc, int yLoc ){
-    QGraphicsRectWidget *tmp = new QGraphicsRectWidget( spriteFName, BLOCK_SIZE, BLOCK_SIZE );
+    QGraphicsRectWidget *tmp = NewSprite( spriteFName );
     tmp->setFlag(QGraphicsItem::ItemIsMovable, true);
     //tmp->setFlag(QGraphicsItem::ItemIsSelectable, true);
     MoveBlock(tmp, uiScene, xLoc, yLoc );
@@ -103,6 +107,13 @@ void engine::MoveBlock(QGraphicsWidget *box, QGraphicsScene *scene, int x, int y
     box->moveBy(BLOCK_SIZE*x,scene->height()-BLOCK_SIZE*yOffset);
 }
 
+/*! \brief engine::PlaceBlock
+ * Puts a block at a grid position, same coordinates as MoveBlock but absolute
+*/
+void engine::PlaceBlock(QGraphicsWidget *box, int x, int y){
+    box->setPos(BLOCK_SIZE*x, uiScene->height()-BLOCK_SIZE*y);
+}
+
 /*! \brief engine::DrawGrid
  * Draws a grid lines through the scene for line up / snap to purposes
  */
@@ -123,84 +134,33 @@ void engine::DrawGrid(QGraphicsScene *scene){
  * Open a file chooser dialog
  */
 int engine::LoadMap(QGraphicsScene *scene){
+    snapshot.fileName.clear();
     parsley->readFile( parentWindow, goodGuys, enemies, blocks, doors,other, NULL );
+    scene->setSceneRect(0, 0, BLOCK_SIZE*parsley->width, BLOCK_SIZE*parsley->height);
 
-    Node *tmp = goodGuys->head;
-    while(tmp != 0){
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
-
-        tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-        //std::cout<< tmp->x<< std::endl << tmp->y << std::endl;
-        scene->addItem(tmp->sprite);
+    for(int i = 0; i < goodGuys->getCount(); i++){
+        ShowSprite(goodGuys, i, scene);
         //asign node to MJ
-        if(tmp->blockType.compare(QString("MJ")) == 0){
-            mj = tmp;
-        }
-        tmp = tmp->next;
-    }
-
-    tmp = enemies->head;
-    while(tmp != 0){
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
-
-        tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-        scene->addItem(tmp->sprite);
-        tmp = tmp->next;
-    }
-
-    tmp = blocks->head;
-    while(tmp != 0){
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
-
-        tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-        scene->addItem(tmp->sprite);
-        //walkable[tmp->x][tmp->y-1] = tmp; Might no be needed here... Not sure
-        tmp = tmp->next;
-    }
-
-    tmp = other->head;
-    while(tmp != 0){
-
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
-
-        if(tmp->blockType.compare( QString("BACKGROUND")) == 0)
-            scene->setBackgroundBrush(QBrush(Qt::black, QPixmap(spriteName)));
-        else{
-            tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-            MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-            scene->addItem(tmp->sprite);
-            tmp->sprite->setZValue(-1);
+        if(goodGuys->kind.at(i) == LEVEL_MJ){
+            mj = goodGuys->handleAt(i);
         }
-        tmp = tmp->next;
     }
 
-    tmp = doors->head;
-    while(tmp != 0){
+    for(int i = 0; i < enemies->getCount(); i++)
+        ShowSprite(enemies, i, scene);
 
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
+    for(int i = 0; i < blocks->getCount(); i++)
+        ShowSprite(blocks, i, scene);
 
-        if(tmp->blockType.compare( QString("BACKGROUND")) == 0)
-            scene->setBackgroundBrush(QBrush(Qt::black, QPixmap(spriteName)));
-        else{
-            tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-            MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-            scene->addItem(tmp->sprite);
-            tmp->sprite->setZValue(-1);
+    objStructure *scenery[2] = { other, doors };
+    for(int l = 0; l < 2; l++){
+        objStructure *list = scenery[l];
+        for(int i = 0; i < list->getCount(); i++){
+            if(list->kind.at(i) == LEVEL_BACKGROUND)
+                scene->setBackgroundBrush(QBrush(Qt::black, sprites->pixmap(list->spriteId.at(i))));
+            else
+                ShowSprite(list, i, scene)->setZValue(-1);
         }
-        tmp = tmp->next;
     }
 
     return 1;
@@ -212,116 +172,376 @@ int engine::LoadMap(QGraphicsScene *scene){
  * it's almost identical to the one above it
  */
 int engine::LoadMap(QGraphicsScene *scene, QString fileName){
-    parsley->readFile(parentWindow, goodGuys, enemies, blocks, doors,other, fileName );
+    TRACE_SCOPE("populate scene");
+    if(!TakePrefetched(fileName))
+        parsley->readFile(parentWindow, goodGuys, enemies, blocks, doors,other, fileName );
 
     life = parsley->lives;
+
+    //the scene is as big as the level says, the view shows the part around mj
+    scene->setSceneRect(0, 0, BLOCK_SIZE*parsley->width, BLOCK_SIZE*parsley->height);
+    viewArea = QRectF(0, 0, BLOCK_SIZE*GRID_WIDTH, BLOCK_SIZE*GRID_HEIGHT);
     for(int x =0; x<life; x++){
-        hearts[x] = new QGraphicsRectWidget(QPixmap("sprites/heart.png"), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(hearts[x], uiScene, 27+x, 20);
+        hearts[x] = NewSprite("heart");
         uiScene->addItem(hearts[x]);
     }
 
-    Node *tmp = goodGuys->head;
-    while(tmp != 0){
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
-
-        tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-        scene->addItem(tmp->sprite);
+    for(int i = 0; i < goodGuys->getCount(); i++){
+        ShowSprite(goodGuys, i, scene);
 
         //asign node to MJ
-        if(tmp->blockType.compare(QString("MJ")) == 0)
-            mj = tmp;
-        else{
-            //set movement to either left or right
-            QTime time = QTime::currentTime();
-            qsrand((uint)time.msec());
-            tmp->movement = qrand() %(2);
-
-            //update item count
-            if(tmp->hasObj)
-                itemCount ++;
-            //draw object that mj already has from saved game
-            else if (tmp->hasObj == false){
-                goodObj[curItems] = new QGraphicsRectWidget(QPixmap(tmp->goodObj), BLOCK_SIZE, BLOCK_SIZE);
-                MoveBlock(goodObj[curItems], uiScene, curItems, 20);
+        if(goodGuys->kind.at(i) == LEVEL_MJ)
+            mj = goodGuys->handleAt(i);
+        //draw object that mj already has from saved game, the hud has room for 5
+        else if (goodGuys->hasObj.at(i) == false){
+            if(curItems < 5){
+                goodObj[curItems] = NewSprite(goodGuys->itemId.at(i));
                 uiScene->addItem(goodObj[curItems]);
-                curItems ++;
             }
+            curItems ++;
         }
-        tmp = tmp->next;
     }
 
-    tmp = enemies->head;
-    while(tmp != 0){
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
+    for(int i = 0; i < enemies->getCount(); i++)
+        ShowSprite(enemies, i, scene);
 
-        tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-        scene->addItem(tmp->sprite);
+    //only the movable blocks get their own widget, the rest is baked into the static layer
+    for(int i = 0; i < blocks->getCount(); i++){
+        if(blocks->kind.at(i) == LEVEL_MBLOCK)
+            ShowSprite(blocks, i, scene);
+    }
 
-        //set movement to either left or right
-        QTime time = QTime::currentTime();
-        qsrand((uint)time.msec());
-        tmp->movement = qrand() %(2);
+    FillSim();
+    BakeStaticLayer(scene, fileName);
+    PlaceHud();
 
-        tmp = tmp->next;
+    itemCount = sim->itemCount();
+    TakeSnapshot(fileName);
+    PrefetchNext();
+    return 1;
+}
+
+/*! \brief engine::FillSim
+ * Puts everything in the lists into an empty simulation. The good guys and the enemies get a random direction
+ * to start walking in, in that order, the same draws headlessGame makes so a replay comes out the same
+ */
+void engine::FillSim(){
+    sim->clear(parsley->width, parsley->height);
+    sim->reserve(goodGuys->getCount() + enemies->getCount() + blocks->getCount() + doors->getCount());
+    sim->setLives(life);
+    simLinks.clear();
+
+    for(int i = 0; i < goodGuys->getCount(); i++){
+        if(goodGuys->kind.at(i) == LEVEL_MJ)
+            sim->addEntity(KIND_MJ, goodGuys->x.at(i), goodGuys->y.at(i));
+        else{
+            //set movement to either left or right
+            goodGuys->movement[i] = random.below(2);
+            sim->addEntity(KIND_GOOD, goodGuys->x.at(i), goodGuys->y.at(i), goodGuys->movement.at(i), goodGuys->hasObj.at(i));
+        }
+        LinkSim(goodGuys, i);
     }
 
-    tmp = blocks->head;
-    while(tmp != 0){
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
+    for(int i = 0; i < enemies->getCount(); i++){
+        enemies->movement[i] = random.below(2);
+        sim->addEntity(KIND_ENEMY, enemies->x.at(i), enemies->y.at(i), enemies->movement.at(i));
+        LinkSim(enemies, i);
+    }
 
-        tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-        MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-        scene->addItem(tmp->sprite);
-        walkable[tmp->y-1][tmp->x] = tmp;
-        tmp = tmp->next;
+    for(int i = 0; i < blocks->getCount(); i++){
+        sim->addEntity(blocks->kind.at(i) == LEVEL_MBLOCK ? KIND_MBLOCK : KIND_BLOCK, blocks->x.at(i), blocks->y.at(i));
+        LinkSim(blocks, i);
     }
 
-    tmp = other->head;
-    while(tmp != 0){
+    for(int i = 0; i < doors->getCount(); i++){
+        if(doors->kind.at(i) != LEVEL_BACKGROUND){
+            sim->addEntity(KIND_DOOR, doors->x.at(i), doors->y.at(i));
+            LinkSim(doors, i);
+        }
+    }
+}
 
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
+/*! \brief engine::TakeSnapshot
+ * Remembers the lists as they are right after fileName was loaded, copied into the arrays the snapshot kept from
+ * the level before
+ */
+void engine::TakeSnapshot(const QString &fileName){
+    snapshot.fileName = fileName;
+    snapshot.goodGuys.copyFrom(*goodGuys);
+    snapshot.enemies.copyFrom(*enemies);
+    snapshot.blocks.copyFrom(*blocks);
+    snapshot.lives = life;
+    snapshot.items = curItems;
+}
 
-        if(tmp->blockType.compare( QString("BACKGROUND")) == 0)
-            scene->setBackgroundBrush(QBrush(Qt::black, QPixmap(spriteName)));
-        else{
-            tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-            MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-            scene->addItem(tmp->sprite);
-            tmp->sprite->setZValue(-1);
+/*! \brief engine::RestoreSnapshot
+ * Puts the level that is up back the way it was loaded without reading it again. The widgets stay in the scene
+ * and are only moved back and shown, crushed enemies come back with the widgets they had, and the static layer is
+ * left as it is. False if fileName isn't the level that is up, then it has to be loaded
+ */
+bool engine::RestoreSnapshot(const QString &fileName){
+    if(snapshot.fileName.isEmpty() || fileName != snapshot.fileName)
+        return false;
+    TRACE_SCOPE("restore snapshot");
+
+    goodGuys->copyFrom(snapshot.goodGuys);
+    enemies->copyFrom(snapshot.enemies);
+    blocks->copyFrom(snapshot.blocks);
+    //back in enemies now
+    crushed.clear();
+
+    objStructure *lists[3] = { goodGuys, enemies, blocks };
+    for(int l = 0; l < 3; l++){
+        objStructure *list = lists[l];
+        for(int i = 0; i < list->getCount(); i++){
+            if(list->sprite.at(i) == NULL)
+                continue;
+            PlaceBlock(list->sprite.at(i), list->x.at(i), list->y.at(i));
+            list->sprite.at(i)->show();
         }
-        tmp = tmp->next;
     }
+    int m = goodGuys->indexOf(mj);
+    if(m != -1)
+        goodGuys->sprite.at(m)->setSpriteBrush(sprites->brush(goodGuys->spriteId.at(m)));
 
-    tmp = doors->head;
-    while(tmp != 0){
+    //the items mj got since the level came up go back, the ones she had from a saved game stay
+    for(int x = snapshot.items; x < 5; x++){
+        widgets.give(goodObj[x]);
+        goodObj[x] = NULL;
+    }
+    curItems = snapshot.items;
+    life = snapshot.lives;
+    for(int x = 0; x < 3; x++){
+        if(hearts[x] != NULL)
+            hearts[x]->show();
+    }
+    mjHasBlock = false;
 
-        QString spriteName("sprites/");
-        spriteName.append(tmp->location.trimmed());
-        spriteName.append(".png");
+    viewArea = QRectF(0, 0, BLOCK_SIZE*GRID_WIDTH, BLOCK_SIZE*GRID_HEIGHT);
+    FillSim();
+    PlaceHud();
+    itemCount = sim->itemCount();
+    return true;
+}
 
-        if(tmp->blockType.compare( QString("BACKGROUND")) == 0)
-            scene->setBackgroundBrush(QBrush(Qt::black, QPixmap(spriteName)));
-        else{
-            tmp->sprite = new QGraphicsRectWidget(QPixmap(spriteName), BLOCK_SIZE, BLOCK_SIZE);
-            MoveBlock(tmp->sprite, scene, tmp->x, tmp->y);
-            scene->addItem(tmp->sprite);
-            tmp->sprite->setZValue(-1);
+/*! \brief engine::TakePrefetched
+ * Adds what levelPrefetch read for fileName to the empty lists, into the room they kept, and hands the sprites it
+ * decoded to the sprite cache. A small note is shown while waiting in case the door was reached before the level was read.
+ * False if fileName wasn't prefetched or couldn't be read, then the parser reads it like before
+ */
+bool engine::TakePrefetched(const QString &fileName){
+    if(prefetch == NULL || !prefetch->has(fileName))
+        return false;
+
+    QLabel *loading = NULL;
+    if(!prefetch->ready(fileName) && parentWindow != NULL){
+        loading = new QLabel("Next level loading...", parentWindow);
+        loading->adjustSize();
+        loading->move((parentWindow->width() - loading->width())/2, (parentWindow->height() - loading->height())/2);
+        loading->show();
+        loading->repaint();
+    }
+    preparedLevel *level = prefetch->take(fileName);
+    delete loading;
+    if(level == NULL || level->result != 0){
+        delete level;
+        return false;
+    }
+
+    objStructure *lists[5] = { goodGuys, enemies, blocks, doors, other };
+    objStructure *prepared[5] = { &level->good, &level->enemies, &level->blocks, &level->doors, &level->other };
+    for(int l = 0; l < 5; l++){
+        objStructure *from = prepared[l];
+        lists[l]->removeAll();
+        lists[l]->reserve(from->getCount());
+        for(int i = 0; i < from->getCount(); i++){
+            int handle = lists[l]->add(from->kind.at(i), from->blockType.at(i), from->location.at(i), from->x.at(i),
+                                       from->y.at(i), from->goodObj.at(i));
+            if(handle != -1)
+                lists[l]->hasObj[lists[l]->indexOf(handle)] = from->hasObj.at(i);
         }
-        tmp = tmp->next;
     }
+    for(QHash<QString, QImage>::const_iterator it = level->images.constBegin(); it != level->images.constEnd(); ++it)
+        sprites->preload(it.key(), it.value());
+
+    if(!level->parsley.curLevel.isEmpty())
+        parsley->curLevel = level->parsley.curLevel;
+    if(!level->parsley.nextLevel.isEmpty())
+        parsley->nextLevel = level->parsley.nextLevel;
+    parsley->lives = level->parsley.lives;
+    parsley->width = level->parsley.width;
+    parsley->height = level->parsley.height;
+    delete level;
+    return true;
+}
 
-    return 1;
+/*! \brief engine::PrefetchNext
+ * Starts reading the level after this one, unless that is already under way
+ */
+void engine::PrefetchNext(){
+    if(parsley->nextLevel.isEmpty())
+        return;
+    if(prefetch == NULL)
+        prefetch = new levelPrefetch();
+    if(!prefetch->has(parsley->nextLevel))
+        prefetch->start(parsley->nextLevel, sprites->decodedNames());
+}
+
+/*! \brief engine::BakeStaticLayer
+ * Sorts the background, the scenery, the doors and the blocks that never move into squares of
+ * STATIC_CHUNK blocks. ShowArea paints a square into one pixmap once it comes into view, the pixmaps
+ * are kept and reused as long as the same level file is loaded again, e.g. on a restart
+ */
+void engine::BakeStaticLayer(QGraphicsScene *scene, QString fileName){
+    QString key = fileName + "@" + QFileInfo(fileName).lastModified().toString(Qt::ISODate);
+    if(key != staticKey){
+        staticPixmaps.clear();
+        staticKey = key;
+    }
+
+    int chunkSize = BLOCK_SIZE*STATIC_CHUNK;
+    chunksX = ((int)scene->width() + chunkSize - 1)/chunkSize;
+    chunksY = ((int)scene->height() + chunkSize - 1)/chunkSize;
+    staticTiles.clear();
+    staticBackground.clear();
+
+    //other and doors sat below everything else, blocks on top of them. a tile is kept as index*4 + layer
+    objStructure *layers[3] = { other, doors, blocks };
+    for(int l = 0; l < 3; l++){
+        objStructure *list = layers[l];
+        for(int i = 0; i < list->getCount(); i++){
+            if(list->kind.at(i) == LEVEL_BACKGROUND)
+                staticBackground.append(QBrush(Qt::black, sprites->pixmap(list->spriteId.at(i))));
+            else if(list->kind.at(i) != LEVEL_MBLOCK){
+                //same spot as a QGraphicsRectWidget placed by MoveBlock, anything off the scene is never seen
+                int px = BLOCK_SIZE*list->x.at(i);
+                int py = scene->height() - BLOCK_SIZE*list->y.at(i);
+                if(px < 0 || py < 0 || px >= scene->width() || py >= scene->height())
+                    continue;
+                staticTiles[(py/chunkSize)*chunksX + px/chunkSize].append(i*4 + l);
+            }
+        }
+    }
+}
+
+/*! \brief engine::BakeChunk
+ * Paints one square of the static layer
+ */
+QPixmap engine::BakeChunk(int chunk){
+    TRACE_SCOPE("bake chunk");
+    int chunkSize = BLOCK_SIZE*STATIC_CHUNK;
+    QRect area = QRect((chunk % chunksX)*chunkSize, (chunk / chunksX)*chunkSize, chunkSize, chunkSize) & uiScene->sceneRect().toRect();
+
+    QPixmap pixmap(area.size());
+    pixmap.fill(Qt::black);
+    QPainter painter(&pixmap);
+
+    //the background tiles from the corner of the scene, not the corner of the square
+    for(int b = 0; b < staticBackground.size(); b++){
+        painter.setBrushOrigin(-area.topLeft());
+        painter.fillRect(pixmap.rect(), staticBackground.at(b));
+    }
+
+    objStructure *layers[3] = { other, doors, blocks };
+    const QVector<int> tiles = staticTiles.value(chunk);
+    for(int t = 0; t < tiles.size(); t++){
+        objStructure *list = layers[tiles.at(t) % 4];
+        int i = tiles.at(t) / 4;
+        QRect cell(BLOCK_SIZE*list->x.at(i) - area.left(), uiScene->height() - BLOCK_SIZE*list->y.at(i) - area.top(), BLOCK_SIZE, BLOCK_SIZE);
+        painter.setBrushOrigin(cell.topLeft());
+        painter.fillRect(cell, sprites->brush(list->spriteId.at(i)));
+    }
+    painter.end();
+    return pixmap;
+}
+
+/*! \brief engine::ShowArea
+ * Called with the part of the scene the view shows. Puts the static squares under it into the scene,
+ * painting the ones that are not cached yet, drops the squares that went out of view and moves the hud along
+ */
+void engine::ShowArea(const QRectF &area){
+    viewArea = area;
+    PlaceHud();
+    if(chunksX == 0 || chunksY == 0)
+        return;
+
+    //one square of margin so walking to the edge of the view does not show black
+    int chunkSize = BLOCK_SIZE*STATIC_CHUNK;
+    int left = qMax(0, (int)floor(area.left()/chunkSize) - 1);
+    int top = qMax(0, (int)floor(area.top()/chunkSize) - 1);
+    int right = qMin(chunksX - 1, (int)floor(area.right()/chunkSize) + 1);
+    int bottom = qMin(chunksY - 1, (int)floor(area.bottom()/chunkSize) + 1);
+
+    QHash<int, QGraphicsPixmapItem*>::iterator it = staticItems.begin();
+    while(it != staticItems.end()){
+        int cx = it.key() % chunksX;
+        int cy = it.key() / chunksX;
+        if(cx < left || cx > right || cy < top || cy > bottom){
+            delete it.value();
+            it = staticItems.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    for(int cy = top; cy <= bottom; cy++){
+        for(int cx = left; cx <= right; cx++){
+            int chunk = cy*chunksX + cx;
+            if(staticItems.contains(chunk))
+                continue;
+            if(!staticPixmaps.contains(chunk))
+                staticPixmaps.insert(chunk, BakeChunk(chunk));
+            QGraphicsPixmapItem *item = uiScene->addPixmap(staticPixmaps.value(chunk));
+            item->setPos(cx*chunkSize, cy*chunkSize);
+            item->setZValue(-1);
+            staticItems.insert(chunk, item);
+        }
+    }
+
+    //forget painted squares that are not in view once there are too many
+    QHash<int, QPixmap>::iterator p = staticPixmaps.begin();
+    while(staticPixmaps.size() > STATIC_CHUNK_CACHE && p != staticPixmaps.end()){
+        if(!staticItems.contains(p.key()))
+            p = staticPixmaps.erase(p);
+        else
+            ++p;
+    }
+}
+
+/*! \brief engine::ClearStaticLayer
+ * Takes the static squares out of the scene, the painted pixmaps stay cached
+ */
+void engine::ClearStaticLayer(){
+    qDeleteAll(staticItems);
+    staticItems.clear();
+    staticTiles.clear();
+    staticBackground.clear();
+    chunksX = 0;
+    chunksY = 0;
+}
+
+/*! \brief engine::PlaceHud
+ * The hearts go in the top right corner of the view, the items mj collected in the top left
+ */
+void engine::PlaceHud(){
+    for(int x = 0; x < 3; x++){
+        if(hearts[x] != NULL)
+            hearts[x]->setPos(viewArea.right() - BLOCK_SIZE*(3-x), viewArea.top());
+    }
+    for(int x = 0; x < 5; x++){
+        if(goodObj[x] != NULL)
+            goodObj[x]->setPos(viewArea.left() + BLOCK_SIZE*x, viewArea.top());
+    }
+}
+
+/*! \brief engine::mjCenter
+ * The middle of mj's sprite, the view follows it
+ */
+QPointF engine::mjCenter(){
+    int m = goodGuys->indexOf(mj);
+    if(m == -1)
+        return uiScene->sceneRect().center();
+    return goodGuys->sprite.at(m)->pos() + QPointF(BLOCK_SIZE/2, BLOCK_SIZE/2);
 }
 
 /*! \brief engine::saveGame
@@ -330,6 +550,7 @@ int engine::LoadMap(QGraphicsScene *scene, QString fileName){
  * the states they are in.
  */
 void engine::saveGame(QString name){
+    TRACE_SCOPE("save");
     parsley->lives = life;
     parsley->createFile(name, goodGuys, enemies, blocks, doors,other);
 }
@@ -338,9 +559,17 @@ void engine::saveGame(QString name){
  *loads level without the file chooser, for now default level
  */
 void engine::loadGame(QString level){
+    PROFILE_SCOPE(PROFILE_LOAD);
     LoadMap(uiScene, level);
 }
 
+/*! \brief engine::setSeed
+ *starts the random numbers over from seed, called before the first level is loaded
+ */
+void engine::setSeed(quint32 seed){
+    random.setSeed(seed);
+}
+
 /*! \brief engine::ClickedOpenMap
  *Opens the file chooser dialog and loads the map
  */
@@ -378,7 +607,16 @@ void engine::ClickedSaveMap(void){
  */
 void engine::CloseMap(void){
     //AskToSave...
-    qDeleteAll( uiScene->items() );
+    ReleaseLevel();
+    //what the editor placed on its own isn't in the lists, its widgets go back to the pool too
+    QList<QGraphicsItem*> items = uiScene->items();
+    for(int i = 0; i < items.size(); i++){
+        QGraphicsRectWidget *widget = dynamic_cast<QGraphicsRectWidget*>(items.at(i));
+        if(widget != NULL)
+            widgets.give(widget);
+        else
+            delete items.at(i);
+    }
     uiScene->setBackgroundBrush(QBrush(Qt::white));
 }
 
@@ -386,37 +624,65 @@ void engine::ClickedDrawGridLines(void){
     DrawGrid( uiScene );
 }
 
-void engine::setBrush(){
-    brush = new QBrush( QPixmap(newName) );
+/*! \brief engine::NewSprite
+ * Creates a block sized widget showing the named sprite, the picture comes from the sprite cache and the widget
+ * from the pool when one was given back
+ */
+QGraphicsRectWidget* engine::NewSprite(const QString &name){
+    return NewSprite(sprites->id(name));
 }
 
-/*! \brief engine::setNewName
- * Sets sprite name so that picture file can be accessed and loaded
+QGraphicsRectWidget* engine::NewSprite(int spriteId){
+    return widgets.take(sprites->brush(spriteId), BLOCK_SIZE, BLOCK_SIZE);
+}
+
+/*! \brief engine::ShowSprite
+ * Gives object i of the list its widget and puts it in the scene where the object is
  */
-void engine::setNewName (QString subName){
-    newName = "sprites/";
-    newName.append(subName);
-    newName.append(".png");
+QGraphicsRectWidget* engine::ShowSprite(objStructure *list, int i, QGraphicsScene *scene){
+    list->sprite[i] = NewSprite(list->spriteId.at(i));
+    MoveBlock(list->sprite.at(i), scene, list->x.at(i), list->y.at(i));
+    scene->addItem(list->sprite.at(i));
+    return list->sprite.at(i);
+}
+
+/*! \brief engine::LinkSim
+ * Remembers which object the entity just added to the simulation stands for
+ */
+void engine::LinkSim(objStructure *list, int i){
+    SimLink link;
+    link.list = list;
+    link.handle = list->handleAt(i);
+    simLinks.append(link);
+}
+
+/*! \brief engine::LoadPoses
+ * Looks up mj's pictures for every way she can face, with and without a block, so moving
+ * her only has to pick one out of the table
+ */
+void engine::LoadPoses(){
+    //[facing + 1][carrying a block]
+    const char *poseNames[3][2] = {
+        { "MJ_move_left", "MJ_move_left_up" },
+        { "MJ_left", "MJ_left_up" },
+        { "MJ_move", "MJ_move_right_up" }
+    };
+    for(int f = 0; f < 3; f++){
+        for(int b = 0; b < 2; b++)
+            mjPoses[f][b] = sprites->brush(sprites->id(poseNames[f][b]));
+    }
 }
 
 /*! \brief engine::loadNext
  *  checks if mj is by the door if she is then load the next level
  */
 void engine::loadNext(){
+    TRACE_SCOPE("loadNext");
     //check if mj is by the door if she is then load the next level
-    Node *tmp = doors->head;
-    while(tmp != NULL){
-        if( (tmp->x == mj->x) && (tmp->y == mj->y)){
-            life = 0;
-
-            QMessageBox msgBox;
-            msgBox.setText("Next Level loading...");
-            msgBox.exec();
-
-            reset(parsley->nextLevel);
-            break;
-        }
-        tmp = tmp->next;
+    if(sim->mjAtDoor()){
+        life = 0;
+        //read while this level was played, see PrefetchNext
+        reset(parsley->nextLevel);
     }
 }
 
@@ -431,275 +697,130 @@ void engine::startOver(){
 /*! \brief engine::reset
  * resets the level by seting objects totheir orignal positions and states
  * cannot be called when animation is still taking place
+ * restarting the level that is up is done in place from the snapshot, any other level is loaded
  */
 void engine::reset(QString level){
+    TRACE_SCOPE("reset");
+    PROFILE_SCOPE(PROFILE_LOAD);
     //Error check on level
     if(level == NULL || level.length() == 0){
         std::cout << "the string that was passed to reset() is not acceptable\n";
         return;
    }
-    //empty the linked list and remove the graphic objects
-    blocks->removeAll();
-    other->removeAll();
-    enemies->removeAll();
-    goodGuys->removeAll();
-    doors->removeAll();
+    if(RestoreSnapshot(level))
+        return;
+
+    ReleaseLevel();
+    loadGame(level);
+}
+
+/*! \brief engine::ReleaseLevel
+ * Empties the lists and the simulation and gives every widget of the level back to the pool, the lists keep
+ * their room and the widgets are handed out again by the next level
+ */
+void engine::ReleaseLevel(){
+    //empty the linked list and remove the graphic objects. the snapshot lists point at the same widgets, they are
+    //only forgotten and keep their arrays for the next level
+    snapshot.fileName.clear();
+    for(int c = 0; c < crushed.size(); c++)
+        widgets.give(crushed.at(c));
+    crushed.clear();
+    objStructure *lists[5] = { blocks, other, enemies, goodGuys, doors };
+    for(int l = 0; l < 5; l++){
+        ReleaseSprites(lists[l]);
+        lists[l]->removeAll();
+    }
 
     //reset userstats
-    mj = NULL;
-    facing = 0;
-    prevFacing = 0;
+    mj = -1;
     itemCount = 0;
     mjHasBlock = false;
+    sim->clear();
+    simLinks.clear();
 
-    //initialize array that holds politers to walkable blocks
-    //useful for moving
-    for(int y = 0; y< 20; y++){
-        for(int x = 0; x<30; x++)
-            walkable[y][x] = NULL;
-    }
+    //the pixmaps stay cached, the next level decides if they can be reused
+    ClearStaticLayer();
 
     //reset and remove goodobj
     for(int x = 0; x<5; x++){
-        if(goodObj[x] != NULL)
-            delete goodObj[x];
+        widgets.give(goodObj[x]);
         goodObj[x] = NULL;
     }
+    curItems = 0;
     //reset and remove hearts
     for(int x = 0; x<3; x++){
-        if(hearts[x] != NULL)
-            delete hearts[x];
+        widgets.give(hearts[x]);
         hearts[x] = NULL;
     }
-
-    loadGame(level);
 }
 
-/*! \brief engine::moveChar
- *     method that is used to move mj.
- *     This method changes her sprite picture and updates her posistion
+/*! \brief engine::ReleaseSprites
+ * Gives the widgets of a list back to the pool, removeAll has nothing left to delete then
  */
-void engine::moveChar(int direction){
-
-    int mjPrevX = mj->x;
-    int mjPrevY = mj->y;
-    if(facing == -direction || facing == 0)
-        facing = facing + direction;
-
-    //face left
-    if (facing == -1){
-        if (mjHasBlock)
-            setNewName("MJ_move_left_up");
-        else
-            setNewName("MJ_move_left");
-    }
-    //face right
-    else if (facing == 1){
-        if (mjHasBlock){
-            setNewName("MJ_move_right_up");
+void engine::ReleaseSprites(objStructure *list){
+    for(int i = 0; i < list->getCount(); i++){
+        if(list->sprite.at(i) != NULL){
+            widgets.give(list->sprite.at(i));
+            list->sprite[i] = NULL;
         }
-        else
-            setNewName("MJ_move");
     }
-    //face foward
-    else if (facing == 0){
-        if (mjHasBlock)
-            setNewName("MJ_left_up");
-        else
-        setNewName("MJ_left");
-    }
-    mj->sprite->brush=new QBrush( QPixmap(newName) );
-    mj->sprite->update();
-
-    //move left
-    if(direction < 0 && prevFacing == facing){
-
-        //going down
-        if(walkable[mj->y-1][mj->x-1] == NULL && walkable[mj->y-2][mj->x-1] == NULL && walkable[mj->y-3][mj->x-1] != NULL){
-            mj->sprite->moveBy(-BLOCK_SIZE, BLOCK_SIZE);
-            mj->x =mj->x - 1;
-            mj->y = mj->y - 1;
-
-            //move block and update block on array
-            if(mjHasBlock){
-                walkable[mjPrevY][mjPrevX]->sprite->moveBy(-BLOCK_SIZE, BLOCK_SIZE);
-                walkable[mj->y][mj->x] =  walkable[mjPrevY][mjPrevX];
-                walkable[mjPrevY][mjPrevX] = NULL;
-
-            }
-        }
-        //going up
-        else if(walkable[mj->y-1][mj->x-1] != NULL && walkable[mj->y][mj->x-1] == NULL){
-            //move block and update block on array
-            if(mjHasBlock && walkable[mj->y+1][mj->x-1] == NULL){
-                mj->sprite->moveBy(-BLOCK_SIZE, -BLOCK_SIZE);
-                mj->x =mj->x - 1;
-                mj->y = mj->y + 1;
-
-                walkable[mjPrevY][mjPrevX]->sprite->moveBy(-BLOCK_SIZE, -BLOCK_SIZE);
-                walkable[mj->y][mj->x] =  walkable[mjPrevY][mjPrevX];
-                walkable[mjPrevY][mjPrevX] = NULL;
-            }
-            else if(!mjHasBlock){
-                mj->sprite->moveBy(-BLOCK_SIZE, -BLOCK_SIZE);
-                mj->x =mj->x - 1;
-                mj->y = mj->y + 1;
-            }
-        }
-        else if( mj->x != 0 && walkable[mj->y-2][mj->x-1] != NULL && walkable[mj->y-1][mj->x-1] == NULL){
+}
 
-             //move block and update block on array
-            if(mjHasBlock && walkable[mj->y][mj->x - 1] == NULL){
-                mj->sprite->moveBy(-BLOCK_SIZE,0);
-                mj->x = mj->x - 1;
+static QString poolLine(const char *name, const poolStats &pool){
+    double hitRate = pool.requests ? 100.0*pool.hits/pool.requests : 0.0;
+    return QString("%1 %2% reused of %3, %4 live, %5 high").arg(QString(name), -9).arg(hitRate, 0, 'f', 1)
+            .arg(pool.requests).arg(pool.live).arg(pool.highWater);
+}
 
-                walkable[mjPrevY][mjPrevX]->sprite->moveBy(-BLOCK_SIZE, 0);
-                walkable[mj->y][mj->x] =  walkable[mjPrevY][mjPrevX];
-                walkable[mjPrevY][mjPrevX] = NULL;
-            }
-            else if(!mjHasBlock){
-                mj->sprite->moveBy(-BLOCK_SIZE,0);
-                mj->x = mj->x - 1;
-            }
-        }
+/*! \brief engine::poolText
+ * One line for the entity slots of all the lists and one for the sprite widgets: the share of requests that
+ * were recycled, how many there are now and the most there were
+ */
+QString engine::poolText(){
+    poolStats entities;
+    objStructure *lists[5] = { goodGuys, enemies, blocks, doors, other };
+    for(int l = 0; l < 5; l++){
+        poolStats list = lists[l]->stats();
+        entities.requests += list.requests;
+        entities.hits += list.hits;
+        entities.live += list.live;
+        entities.highWater += list.highWater;
     }
-    //right
-    else if(direction > 0 && prevFacing == facing){
-        //going up
-        if(walkable[mj->y-1][mj->x+1] != NULL && walkable[mj->y][mj->x+1] == NULL){
-
-            if(mjHasBlock && walkable[mj->y+1][mj->x+1] == NULL){
-                mj->sprite->moveBy(BLOCK_SIZE, -BLOCK_SIZE);
-                mj->x = mj->x + 1;
-                mj->y = mj->y + 1;
+    return poolLine("entities", entities) + "\n" + poolLine("sprites", widgets.stats());
+}
 
-                walkable[mjPrevY][mjPrevX]->sprite->moveBy(BLOCK_SIZE, -BLOCK_SIZE);
-                walkable[mj->y][mj->x] =  walkable[mjPrevY][mjPrevX];
-                walkable[mjPrevY][mjPrevX] = NULL;
-            }
-            //move block and update block on array
-            else if(!mjHasBlock){
-                mj->sprite->moveBy(BLOCK_SIZE, -BLOCK_SIZE);
-                mj->x = mj->x + 1;
-                mj->y = mj->y + 1;
-            }
-        }
-        //going down
-        else if(walkable[mj->y-1][mj->x+1] == NULL && walkable[mj->y-2][mj->x+1] == NULL && walkable[mj->y-3][mj->x+1] != NULL){
-            mj->sprite->moveBy(BLOCK_SIZE, BLOCK_SIZE);
-            mj->x = mj->x + 1;
-            mj->y = mj->y - 1;
-
-            //move block and update block on array
-            if(mjHasBlock){
-                walkable[mjPrevY][mjPrevX]->sprite->moveBy(BLOCK_SIZE, BLOCK_SIZE);
-                walkable[mj->y][mj->x] =  walkable[mjPrevY][mjPrevX];
-                walkable[mjPrevY][mjPrevX] = NULL;
+/*! \brief engine::moveChar
+ *     method that is used to move mj.
+ *     The simulation decides where she goes, this changes her sprite picture and mirrors her posistion
+ */
+void engine::moveChar(int direction){
+    sim->clearEvents();
+    sim->moveChar(direction);
 
-            }
-        }
-        else if(mj->x != 29 && walkable[mj->y-2][mj->x+1] != NULL && walkable[mj->y-1][mj->x+1] == NULL){
-            //move block and update block on array
-            if(mjHasBlock && walkable[mj->y][mj->x+1] == NULL){
-                mj->sprite->moveBy(BLOCK_SIZE,0);
-                mj->x = mj->x + 1;
-
-                walkable[mjPrevY][mjPrevX]->sprite->moveBy(BLOCK_SIZE, 0);
-                walkable[mj->y][mj->x] =  walkable[mjPrevY][mjPrevX];
-                walkable[mjPrevY][mjPrevX] = NULL;
-            }
-            else if(!mjHasBlock){
-                mj->sprite->moveBy(BLOCK_SIZE,0);
-                mj->x = mj->x + 1;
-            }
-        }
-    }
+    //pick her picture out of the pose table, nothing gets decoded here
+    int m = goodGuys->indexOf(mj);
+    if(m != -1)
+        goodGuys->sprite.at(m)->setSpriteBrush(mjPoses[sim->facing() + 1][sim->mjHasBlock() ? 1 : 0]);
 
-    prevFacing = facing;
-    safeToCheckEnemyCollision = true;
+    mirrorEvents();
 }
 
 /*! \brief engine::moveGood
  * moves the good characters
  */
 void engine::moveGood(){
-    Node *tmp = goodGuys->head;
-    while(tmp != 0){
-        if(tmp != mj){
-
-            int direction = tmp->movement;
-            //left
-            if(direction == 0){
-                if( tmp->x != 0 && walkable[tmp->y-2][tmp->x-1] != NULL && walkable[tmp->y-1][tmp->x-1] == NULL){
-                    tmp->sprite->moveBy(-BLOCK_SIZE,0);
-                    tmp->x = tmp->x - 1;
-                }
-                //at edge, turn right
-                else if(tmp->x != 29 && walkable[tmp->y-2][tmp->x+1] != NULL){
-                    //animate sprite here
-                    tmp->movement = 1;
-                }
-            }
-            //right
-            else if(direction == 1){
-                if(tmp->x != 29 && walkable[tmp->y-2][tmp->x+1] != NULL && walkable[tmp->y-1][tmp->x+1] == NULL){
-                    tmp->sprite->moveBy(BLOCK_SIZE,0);
-                    tmp->x = tmp->x + 1;
-                }
-                //at edge turn left
-                else if( tmp->x != 0 && walkable[tmp->y-2][tmp->x-1] != NULL ){
-                    //animate sprite here
-                    tmp->movement = 0;
-                }
-            }
-        }
-        tmp = tmp->next;
-    }
+    sim->clearEvents();
+    sim->moveGood();
+    mirrorEvents();
 }
 
 /*! \brief engine::moveEnemies
- * moves the good characters
+ * moves the enemies
  */
 void engine::moveEnemies(){
-    Node *tmp = enemies->head;
-    while(tmp != 0){
-        int direction = tmp->movement;
-        //left
-        if(direction == 0){
-            if( tmp->x != 0 && walkable[tmp->y-2][tmp->x-1] != NULL && walkable[tmp->y-1][tmp->x-1] == NULL){
-                tmp->sprite->moveBy(-BLOCK_SIZE,0);
-                tmp->x = tmp->x - 1;
-                safeToCheckEnemyCollision = true;
-            }
-            //at edge, turn right
-            else if(tmp->x != 29 && walkable[tmp->y-2][tmp->x+1] != NULL){
-
-                /*tmp->sprite->moveBy(BLOCK_SIZE,0);
-                tmp->x = tmp->x + 1;
-                */
-                //animate sprite here
-                tmp->movement = 1;
-            }
-        }
-        //right
-        else if(direction == 1){
-            if(tmp->x != 29 && walkable[tmp->y-2][tmp->x+1] != NULL && walkable[tmp->y-1][tmp->x+1] == NULL){
-                tmp->sprite->moveBy(BLOCK_SIZE,0);
-                tmp->x = tmp->x + 1;
-                safeToCheckEnemyCollision = true;
-            }
-            //at edge turn left
-            else if( tmp->x != 0 && walkable[tmp->y-2][tmp->x-1] != NULL ){
-                /*
-                tmp->sprite->moveBy(-BLOCK_SIZE,0);
-                tmp->x = tmp->x - 1;
-                */
-                //animate sprite here
-                tmp->movement = 0;
-            }
-        }
-        tmp = tmp->next;
-    }
+    sim->clearEvents();
+    sim->moveEnemies();
+    mirrorEvents();
 }
 
 /*! \brief engine::getBlock
@@ -708,92 +829,18 @@ void engine::moveEnemies(){
  * is facing
  */
 void engine::getBlock(){
-    int y = mj->y;
-    int x = mj->x + facing;
-    if(facing ==0)
-        y = y - 1;
-
-
-    //checks to see if the block that mj is facing is of type MBLOCK
-    if(walkable[y-1][x]!= 0 && walkable[y-1][x]->blockType.compare("MBLOCK") == 0){
-        int mjX = mj->x;
-        int mjY = mj->y;
-
-        if(facing == 0){
-            walkable[y-1][x]->sprite->moveBy(0, -BLOCK_SIZE);
-            walkable[mjY-1][mjX] = walkable[y-1][x];
-            walkable[y-1][x] = 0;
-
-            mj->sprite->moveBy(0, BLOCK_SIZE);
-            mj->y = mj->y-1;
-        }
-        else{
-            walkable[y-1][x]->sprite->moveBy((mjX - x) * 30, -(mjY -y+1) * 30);
-            walkable[mjY][mjX] = walkable[y-1][x];
-            walkable[y-1][x] = 0;
-        }
-        mjHasBlock = true;
-    }
+    sim->clearEvents();
+    sim->getBlock();
+    mirrorEvents();
 }
 
 /*! \brief engine::dropBlock()
- * using mj's position we find the position of the block she is carrying
- * and check to see if the place where the player wants to drop it is a legal
- * place, ie there is no block there. If block lands on an enemy, they die (disappear)
+ * drops the block mj is carrying in front of her. If block lands on an enemy, they die (disappear)
  */
 void engine::dropBlock(){
-
-    //has to face left or right
-    if(facing == 0)
-        return;
-
-    //get x y for block to be used in the walkable array
-    int blockY = mj->y;
-    int blockX = mj->x;
-
-    //place block
-    Node *ptr;
-    if(walkable[blockY][blockX + facing] == NULL){
-        walkable[blockY][blockX]->sprite->moveBy(facing * 30, 0);
-        walkable[blockY][blockX]->x = blockX + facing;
-        walkable[blockY][blockX]->y = blockY + 1;
-
-        walkable[blockY][blockX + facing] = walkable[blockY][blockX];
-        walkable[blockY][blockX] = NULL;
-        ptr = walkable[blockY][blockX + facing];
-
-        //move block down if possible
-        Node *tmp = walkable[blockY - 1][blockX + facing];
-        int count = 0;
-        while(tmp == NULL){
-            walkable[blockY - count][blockX + facing]->sprite->moveBy(0, BLOCK_SIZE);
-            walkable[blockY - count][blockX + facing]->y = walkable[blockY - count][blockX + facing]->y - 1;
-
-            walkable[blockY - count - 1][blockX + facing] = walkable[blockY - count][blockX + facing];
-            walkable[blockY - count][blockX + facing] = NULL;
-
-            ptr = walkable[blockY - count - 1][blockX + facing];
-
-            count ++;
-            tmp = walkable[blockY - 1 - count][blockX + facing];
-        }
-
-        //check to see if enemy got crushed
-        tmp = enemies->head;
-        while(tmp != 0){
-            if((ptr->x == tmp->x) && (ptr->y == tmp->y)){
-                //enemy got crushed remove it and play sound fx
-                player->setMedia(QUrl::fromLocalFile(QFileInfo("sounds/squish.wav").absoluteFilePath()));
-                player->setVolume(60);
-                player->play();
-                enemies->remove(tmp);
-            }
-            tmp = tmp->next;
-        }
-        //update mj block status
-        mjHasBlock = false;
-    }
-
+    sim->clearEvents();
+    sim->dropBlock();
+    mirrorEvents();
 }
 
 /*! \brief engine::checkCollision()
@@ -803,50 +850,78 @@ void engine::dropBlock(){
  *  when she runs out the game resets to the beginning of that level
  */
 void engine::checkCollisions(){
-    //check to see if mj collides with a good guy
-    Node *tmp = goodGuys->head;
-    while(tmp != NULL){
-        if(tmp->blockType.compare(QString("MJ")) != 0 ){
-            if((tmp->x == mj->x) && (tmp->y == mj->y) && (tmp->hasObj)) {
-
-                //draw object on screen
-                goodObj[curItems] = new QGraphicsRectWidget(QPixmap(tmp->goodObj), BLOCK_SIZE, BLOCK_SIZE);
-                MoveBlock(goodObj[curItems], uiScene, curItems, 20);
-                uiScene->addItem(goodObj[curItems]);
+    sim->clearEvents();
+    sim->checkCollisions();
+    mirrorEvents();
+}
 
-                //play sound fx
-                player->setMedia(QUrl::fromLocalFile(QFileInfo("sounds/chime.wav").absoluteFilePath() ));
-                player->setVolume(70);
-                player->play();
+bool engine::collisionPending(){
+    return sim->collisionPending();
+}
 
-                tmp->hasObj = false;
-                itemCount --;
-                curItems ++;
-            }
+/*! \brief engine::mirrorEvents()
+ *  copies what changed in the simulation into the nodes and the scene, and plays the sound fx
+ */
+void engine::mirrorEvents(){
+    const std::vector<SimEvent> &events = sim->events();
+
+    for(unsigned int i = 0; i < events.size(); i++){
+        const SimEvent &e = events[i];
+        objStructure *list = simLinks.at(e.id).list;
+        int n = list ? list->indexOf(simLinks.at(e.id).handle) : -1;
+        if(n == -1)
+            continue;
+
+        if(e.type == EVENT_MOVED){
+            list->x[n] = sim->entity(e.id).x;
+            list->y[n] = sim->entity(e.id).y;
+            PlaceBlock(list->sprite.at(n), list->x.at(n), list->y.at(n));
         }
-        tmp = tmp->next;
-    }
-
-    //collides with enemies
-    tmp = enemies->head;
-    while(tmp != NULL){
-        if( (mj->x == tmp->x) && (mj->y == tmp->y) && safeToCheckEnemyCollision ){
-            life --;
-            if(life >=0){
-                delete hearts[life];
-                hearts[life] = NULL;
+        else if(e.type == EVENT_ITEM){
+            //draw object on screen, generated levels can have more than the hud fits
+            if(curItems < 5){
+                goodObj[curItems] = NewSprite(list->itemId.at(n));
+                uiScene->addItem(goodObj[curItems]);
             }
-            if(life <= 0){
-                //remove everything that is drawned and reload the level
-                QMessageBox msgBox;
-                msgBox.setText("Your lives are gone. Restarting level");
-                msgBox.exec();
 
-                reset(parsley->curLevel);
-            }
+            //play sound fx
+            assets().setMedia(player, "sounds/chime.wav");
+            player->setVolume(70);
+            player->play();
 
-            safeToCheckEnemyCollision = false;
+            list->hasObj[n] = false;
+            curItems ++;
+            PlaceHud();
+        }
+        else if(e.type == EVENT_CRUSHED){
+            //enemy got crushed remove it and play sound fx
+            assets().setMedia(player, "sounds/squish.wav");
+            player->setVolume(60);
+            player->play();
+            //the widget is only hidden, a restart puts it back
+            list->sprite.at(n)->hide();
+            crushed.append(list->sprite.at(n));
+            list->sprite[n] = NULL;
+            list->remove(simLinks.at(e.id).handle);
+            simLinks[e.id].list = NULL;
+        }
+        else if(e.type == EVENT_HURT){
+            life --;
+            if(life >=0 && life < 3 && hearts[life] != NULL)
+                hearts[life]->hide();
+        }
+        else if(e.type == EVENT_DIED){
+            //remove everything that is drawned and reload the level
+            QMessageBox msgBox;
+            msgBox.setText("Your lives are gone. Restarting level");
+            msgBox.exec();
+
+            reset(parsley->curLevel);
+            return;
         }
-        tmp = tmp->next;
     }
+
+    life = sim->lives();
+    itemCount = sim->itemCount();
+    mjHasBlock = sim->mjHasBlock();
 }
@@ -11,6 +11,12 @@
 #include "objects.h"
 #include "parser.h"
 #include "objStructure.h"
+#include "simulation.h"
+#include "gamerandom.h"
+#include "spritecache.h"
+#include "assets.h"
+#include "levelprefetch.h"
+#include "frameprofiler.h"
 #include "definitions.h"
 
 class engine
@@ -25,6 +31,7 @@ public:
     void SetScene( QGraphicsScene *scene );
     void SetParentWindow(QWidget *pWindow );
     void loadGame(QString level);
+    void setSeed(quint32 seed);
     void saveGame(QString name);
     void ClickedOpenMap(void);
     void ClickedSaveMap(void);
@@ -39,11 +46,17 @@ public:
     void dropBlock();
     void loadNext();
     void checkCollisions();
+    //the simulation has a contact to check, the game loop calls checkCollisions then
+    bool collisionPending();
     void startOver();
-
-    //made mj and the array of blocks public, might change it back to private later if that is better
-    Node *mj;
-    Node *walkable[20][30];
+    QPointF mjCenter();
+    void ShowArea(const QRectF &area);
+    //how much the entity slots and the sprite pool were reused, for the profiler overlay
+    QString poolText();
+
+    //made mj public, might change it back to private later if that is better
+    //it is mj's handle in goodGuys
+    int mj;
     QGraphicsRectWidget *goodObj[5];
     bool mjHasBlock;
     int itemCount;
@@ -59,26 +72,81 @@ private:
     objStructure *other;
     objStructure *doors;
 
-    QBrush *brush;
-    QString newName;
     QMediaPlayer *player;
     QGraphicsScene *uiScene;
     QWidget *parentWindow;
     QGraphicsRectWidget *hearts[3];
 
-    //variables used for moving and facing MJ in the right place
-    int facing;
-    int prevFacing;
+    //every sprite is decoded once, mj's pictures are looked up once into mjPoses[facing + 1][carrying]
+    spriteCache *sprites;
+    QBrush mjPoses[3][2];
+
+    //the game rules live in the simulation, simLinks maps its entity ids back to the objects
+    struct SimLink{
+        objStructure *list;
+        int handle;
+    };
+    simulation *sim;
+    QVector<SimLink> simLinks;
+    //everything random in the rules comes from here, a replay sets the seed the session was recorded with
+    gameRandom random;
 
     int curItems;
-    bool safeToCheckEnemyCollision;
+
+    //background, scenery, doors and fixed blocks painted in squares of STATIC_CHUNK blocks. staticTiles lists
+    //what is in each square, only squares in view get painted and the pixmaps are reused on a restart
+    QHash<int, QVector<int> > staticTiles;
+    QVector<QBrush> staticBackground;
+    QHash<int, QGraphicsPixmapItem*> staticItems;
+    QHash<int, QPixmap> staticPixmaps;
+    QString staticKey;
+    int chunksX;
+    int chunksY;
+
+    //reads the level NEXT names while this one is played, made when the first level is up
+    levelPrefetch *prefetch;
+
+    //the lists the way they were when the level came up, a restart copies them back and reuses the widgets
+    //they point at. doors and other never change while playing so they aren't kept
+    struct LevelSnapshot{
+        QString fileName;
+        objStructure goodGuys;
+        objStructure enemies;
+        objStructure blocks;
+        int lives;
+        int items;
+    };
+    LevelSnapshot snapshot;
+    //widgets of crushed enemies, hidden until a restart brings them back
+    QVector<QGraphicsRectWidget*> crushed;
+    //every sprite widget comes from here and goes back here when its level is cleared
+    spritePool widgets;
+
+    //the part of the scene the view shows, the hud sits along its top
+    QRectF viewArea;
 
     void DrawGrid(QGraphicsScene *scene);
     void MoveBlock(QGraphicsWidget *box, QGraphicsScene *scene, int x, int y);
-    void setNewName (QString subName);
-    void setBrush();
+    void PlaceBlock(QGraphicsWidget *box, int x, int y);
+    void mirrorEvents();
+    QGraphicsRectWidget* NewSprite(const QString &name);
+    QGraphicsRectWidget* NewSprite(int spriteId);
+    QGraphicsRectWidget* ShowSprite(objStructure *list, int i, QGraphicsScene *scene);
+    void LinkSim(objStructure *list, int i);
+    void ReleaseSprites(objStructure *list);
+    void ReleaseLevel();
+    void FillSim();
+    void LoadPoses();
     int LoadMap(QGraphicsScene *scene);
     int LoadMap(QGraphicsScene *scene, QString fileName);
+    void BakeStaticLayer(QGraphicsScene *scene, QString fileName);
+    QPixmap BakeChunk(int chunk);
+    void ClearStaticLayer();
+    bool TakePrefetched(const QString &fileName);
+    void PrefetchNext();
+    void PlaceHud();
+    void TakeSnapshot(const QString &fileName);
+    bool RestoreSnapshot(const QString &fileName);
     void reset(QString level);
 
 
@@ -0,0 +1,144 @@
+/*! \abstract frameProfiler
+ *         Times what a tick of the game costs: the npc patrol, collisions, mj's moves, painting the scene and loading
+ *         levels, with the allocations made and the number of items in the scene. The last PROFILE_SECONDS are kept for
+ *         the overlay in gamewindow and can be written out as csv. The timing is a clock read at each end of a section,
+ *         cheap enough to stay in debug builds, and release builds leave it out unless MJ_PROFILE is defined.
+ */
+
+#include "frameprofiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#ifdef PROFILE_ENABLED
+//counting every allocation the game makes. Only the game is built with this file, the editor and the tools are not
+void *operator new(std::size_t size){
+    frameProfiler::allocationCount().fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if(p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](std::size_t size){
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept{
+    free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept{
+    free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept{
+    free(p);
+}
+#endif
+
+/*! \brief frameProfiler::endTick
+ *  files the tick away and starts the next one
+ */
+void frameProfiler::endTick(quint64 tick, int sceneItems){
+    quint64 allocations = allocationCount().load(std::memory_order_relaxed);
+    if(sceneItems >= 0)
+        lastSceneItems = sceneItems;
+
+    current.tick = tick;
+    current.allocations = allocations - lastAllocations;
+    current.sceneItems = lastSceneItems;
+    ring[next] = current;
+    next = (next + 1) % ring.size();
+    filled = qMin(filled + 1, ring.size());
+
+    memset(&current, 0, sizeof(current));
+    childNs = 0;
+    lastAllocations = allocations;
+}
+
+/*! \brief frameProfiler::percentiles
+ *  nearest rank over the ticks the section ran in, npcs only walk every NPC_TICKS ticks and the rest would be zeros
+ */
+bool frameProfiler::percentiles(int section, qint64 *out) const{
+    std::vector<qint64> times;
+    times.reserve(filled);
+    for(int i = 0; i < filled; i++){
+        if(ring[i].ns[section] > 0)
+            times.push_back(ring[i].ns[section]);
+    }
+    if(times.empty())
+        return false;
+
+    std::sort(times.begin(), times.end());
+    const int ranks[3] = { 50, 95, 99 };
+    for(int r = 0; r < 3; r++){
+        int rank = (int)((ranks[r]*times.size() + 99)/100);
+        out[r] = times[qBound(0, rank - 1, (int)times.size() - 1)];
+    }
+    out[3] = times.back();
+    return true;
+}
+
+/*! \brief frameProfiler::overlayText
+ *  a table of the percentiles in microseconds, with the allocations and scene items of the last tick
+ */
+QString frameProfiler::overlayText() const{
+    QString text = QString("%1      p50      p95      p99      max\n").arg(QString("us"), -12);
+    for(int s = 0; s < PROFILE_SECTIONS; s++){
+        qint64 p[4];
+        text += QString("%1").arg(QString(sectionName(s)), -12);
+        if(percentiles(s, p)){
+            for(int i = 0; i < 4; i++)
+                text += QString(" %1").arg(p[i]/1000.0, 8, 'f', 1);
+        }
+        else
+            text += QString(" %1").arg(QString("-"), 8);
+        text += "\n";
+    }
+
+    quint64 allocations = 0;
+    quint64 maxAllocations = 0;
+    for(int i = 0; i < filled; i++){
+        allocations += ring[i].allocations;
+        maxAllocations = qMax(maxAllocations, ring[i].allocations);
+    }
+    int last = (next + ring.size() - 1) % ring.size();
+    text += QString("allocations per tick %1 mean, %2 max\n").arg(filled ? (double)allocations/filled : 0.0, 0, 'f', 1)
+            .arg(maxAllocations);
+    text += QString("scene items %1, last %2 s, F4 writes csv").arg(filled ? ring[last].sceneItems : 0)
+            .arg(filled*TICK_MS/1000);
+    return text;
+}
+
+/*! \brief frameProfiler::writeCsv
+ *  one line per tick, oldest first, times in microseconds
+ */
+bool frameProfiler::writeCsv(const QString &fileName, QString &error) const{
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text)){
+        error = fileName + ": can not write";
+        return false;
+    }
+    QTextStream out(&file);
+    out << "tick";
+    for(int s = 0; s < PROFILE_SECTIONS; s++)
+        out << "," << sectionName(s) << "_us";
+    out << ",allocations,scene_items\n";
+
+    int first = (next + ring.size() - filled) % ring.size();
+    for(int i = 0; i < filled; i++){
+        const profileTick &t = ring[(first + i) % ring.size()];
+        out << t.tick;
+        for(int s = 0; s < PROFILE_SECTIONS; s++)
+            out << "," << QString::number(t.ns[s]/1000.0, 'f', 1);
+        out << "," << t.allocations << "," << t.sceneItems << "\n";
+    }
+    return true;
+}
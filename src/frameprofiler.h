@@ -0,0 +1,111 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QtCore>
+#include <atomic>
+#include <cstring>
+#include "simulation.h"
+#include "trace.h"
+
+//debug builds time the game loop, release builds only with DEFINES += MJ_PROFILE. Without it the scopes are only trace spans
+#if !defined(QT_NO_DEBUG) || defined(MJ_PROFILE)
+#define PROFILE_ENABLED
+#endif
+
+//how far back the overlay and the csv dump look
+#define PROFILE_SECONDS ( 30 )
+#define PROFILE_TICKS ( PROFILE_SECONDS*1000/TICK_MS )
+
+enum ProfileSection{
+    PROFILE_ENEMIES,
+    PROFILE_GOOD,
+    PROFILE_COLLISIONS,
+    PROFILE_MOVECHAR,
+    PROFILE_PAINT,
+    PROFILE_LOAD,
+    PROFILE_SECTIONS
+};
+
+/* what one tick cost. Keys and paints between two steps count towards the step after them */
+struct profileTick{
+    quint64 tick;
+    qint64 ns[PROFILE_SECTIONS];
+    quint64 allocations;
+    int sceneItems;
+};
+
+/* keeps the last PROFILE_TICKS ticks in a ring. Times are exclusive: a level load inside checkCollisions
+   counts as load, not as collisions */
+class frameProfiler
+{
+public:
+    frameProfiler() : ring(PROFILE_TICKS), next(0), filled(0), childNs(0), lastAllocations(0), lastSceneItems(0){
+        memset(&current, 0, sizeof(current));
+    }
+
+    void begin(qint64 &childSaved) { childSaved = childNs; childNs = 0; }
+    void end(int section, qint64 elapsed, qint64 childSaved){
+        current.ns[section] += elapsed - childNs;
+        childNs = childSaved + elapsed;
+    }
+    //closes the tick, sceneItems is -1 when it wasn't counted this tick
+    void endTick(quint64 tick, int sceneItems);
+
+    //p50, p95, p99 and the max over the ticks a section ran in, in nanoseconds. False if it never ran
+    bool percentiles(int section, qint64 *out) const;
+    QString overlayText() const;
+    bool writeCsv(const QString &fileName, QString &error) const;
+
+    static const char *sectionName(int section){
+        static const char *names[PROFILE_SECTIONS] = { "moveEnemies", "moveGood", "collisions", "moveChar", "paint", "load" };
+        return names[section];
+    }
+    //every operator new since the game started, counted when the game is built with profiling
+    static std::atomic<quint64> &allocationCount(){
+        static std::atomic<quint64> count(0);
+        return count;
+    }
+
+private:
+    QVector<profileTick> ring;
+    int next;
+    int filled;
+    profileTick current;
+    qint64 childNs;
+    quint64 lastAllocations;
+    int lastSceneItems;
+};
+
+//the game has one loop, so one profiler that the engine and the window both report to
+inline frameProfiler &profiler(){
+    static frameProfiler p;
+    return p;
+}
+
+/* times the rest of the block it is declared in, for the overlay and as a span in the trace */
+class profileScope
+{
+public:
+    explicit profileScope(int section) : section(section), start(traceLog::now()){
+        profiler().begin(childSaved);
+    }
+    ~profileScope(){
+        qint64 elapsed = traceLog::now() - start;
+        profiler().end(section, elapsed, childSaved);
+        traceLog::span(frameProfiler::sectionName(section), start, elapsed);
+    }
+
+private:
+    int section;
+    qint64 start;
+    qint64 childSaved;
+};
+
+//without the profiler the sections are still spans in the trace
+#ifdef PROFILE_ENABLED
+#define PROFILE_SCOPE(section) profileScope TRACE_NAME(profileScope, __LINE__)(section)
+#else
+#define PROFILE_SCOPE(section) TRACE_SCOPE(frameProfiler::sectionName(section))
+#endif
+
+#endif // FRAMEPROFILER_H
@@ -4,27 +4,41 @@ QT += multimedia
 
 TEMPLATE = app
 
+include(core.pri)
+
+#the F3 overlay and allocation counting are in debug builds, uncomment to keep them in a release build
+#DEFINES += MJ_PROFILE
+
 SOURCES = \
     objects.cpp \
+    spritecache.cpp \
+    assets.cpp \
     engine.cpp \
     objStructure.cpp \
     parser.cpp \
+    levelprefetch.cpp \
     editormainwindow.cpp \
     main.cpp \
     start.cpp \
     gamewindow.cpp \
-    graphicsvieweditor.cpp
+    graphicsvieweditor.cpp \
+    frameprofiler.cpp
 
 HEADERS += \
     objects.h \
+    spritecache.h \
+    assets.h \
+    assetpack.h \
     engine.h \
     objStructure.h \
     parser.h \
+    levelprefetch.h \
     editormainwindow.h \
     start.h \
     gamewindow.h \
     graphicsvieweditor.h \
-    definitions.h
+    definitions.h \
+    frameprofiler.h
 
 TARGET = baking_game
 
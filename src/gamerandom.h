@@ -0,0 +1,27 @@
+#ifndef GAMERANDOM_H
+#define GAMERANDOM_H
+
+#include <stdint.h>
+
+/* the random numbers the game rules use, from one seed so a session can be played again. splitmix64, it is small
+   and gives the same numbers on every platform, unlike rand() */
+class gameRandom
+{
+public:
+    gameRandom(uint32_t seed = 1) { setSeed(seed); }
+
+    void setSeed(uint32_t seed) { state = seed; }
+    uint32_t next(){
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+        return (uint32_t)((z ^ (z >> 31)) >> 32);
+    }
+    //0 .. n-1
+    int below(int n) { return (int)(next() % (uint32_t)n); }
+
+private:
+    uint64_t state;
+};
+
+#endif // GAMERANDOM_H
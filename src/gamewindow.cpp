@@ -5,13 +5,24 @@
  */
 
 #include "gamewindow.h"
+#include "frameprofiler.h"
 #include <iostream>
 
+//the game's view, it times its paints for the profiler
+class gameView : public GraphicsView
+{
+protected:
+    void paintEvent(QPaintEvent *event){
+        PROFILE_SCOPE(PROFILE_PAINT);
+        GraphicsView::paintEvent(event);
+    }
+};
+
 /*! \brief gamewindow::gamewindow
- * Loads games depending on if its new or saved. Also sets up timer for music to play
- * in the background. The order of the music is randomly picked.
+ * Loads games depending on if its new or saved, or plays a replay. Also sets up the game loop timer and the music
+ * played in the background. The order of the music is randomly picked.
  */
-gamewindow::gamewindow(QWidget *parent, bool newGame, QString sessionName) :
+gamewindow::gamewindow(QWidget *parent, bool newGame, QString sessionName, QString replayFile) :
     QMainWindow(parent),
     ui(new Ui::gamewindow)
 {
@@ -25,14 +36,40 @@ gamewindow::gamewindow(QWidget *parent, bool newGame, QString sessionName) :
         //score and other stuff will go here or maybe lets not have a score but life count
     }
 
+    //a new seed every session, a replay brings the one it was recorded with
+    quint32 seed = (quint32)QDateTime::currentMSecsSinceEpoch();
+    replaying = false;
+    playbackNext = 0;
+    if(!replayFile.isEmpty()){
+        std::string error;
+        if(playback.load(replayFile.toStdString(), error)){
+            replaying = true;
+            seed = playback.seed;
+            load = QString::fromStdString(playback.level);
+        }
+        else
+            std::cout << error << "\n";
+    }
+
+    uint64_t levelHash = 0;
+    replay::hashFile(load.toStdString(), levelHash);
+    if(replaying && levelHash != playback.levelHash)
+        std::cout << "the level changed since the replay was recorded, it will play differently\n";
+    recording.start(seed, load.toStdString(), levelHash);
+    music.setSeed(seed ^ 0x5A5A5A5A);
+
     nextLevel = "levels/defaultlevel";
 
+    traceLog::nameThread("game loop");
+    lastTrace = 0;
+
     ui->setupUi(this);
     ginny = new engine();
+    ginny->setSeed(seed);
 
     //this->setWindowFlags(Qt::FramelessWindowHint);
 
-    graphicsView = new GraphicsView();
+    graphicsView = new gameView();
     graphicsView->setGeometry( QRect(0, 0, BLOCK_SIZE*30, BLOCK_SIZE*20 ) );
 
     graphicsScene = new QGraphicsScene( QRect(0,0,BLOCK_SIZE*30,BLOCK_SIZE*20) );
@@ -43,34 +80,34 @@ gamewindow::gamewindow(QWidget *parent, bool newGame, QString sessionName) :
 
     graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    //the game loop asks for repaints itself once a step is done
+    graphicsView->setViewportUpdateMode(QGraphicsView::NoViewportUpdate);
+
+    profileOverlay = new QLabel(graphicsView);
+    profileOverlay->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    profileOverlay->setStyleSheet("QLabel { background-color: rgba(0, 0, 0, 160); color: white; padding: 4px; }");
+    profileOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    profileOverlay->move(0, BLOCK_SIZE);
+    profileOverlay->hide();
 
     ginny->loadGame(load);
+    followMJ();
 
-    QTimer *timer = new QTimer(this);
-    connect(timer, SIGNAL(timeout()), this, SLOT(moveEvent()));
-    timer->start(500);
+    accumulator = 0;
+    tickCount = 0;
+    paused = false;
+    inStep = false;
+    renderPending = true;
 
-    QTimer *mediaTimer = new QTimer(this);
-    connect(mediaTimer, SIGNAL(timeout()), this, SLOT(mediaEvent()));
-    mediaTimer->start(20);
+    loopTimer = new QTimer(this);
+    loopTimer->setTimerType(Qt::PreciseTimer);
+    loopTimer->setInterval(TICK_MS);
+    connect(loopTimer, SIGNAL(timeout()), this, SLOT(loopEvent()));
 
-    //choose random song
-    QTime time = QTime::currentTime();
-    qsrand((uint)time.msec());
-    int random = qrand() % (3);
-    QString song;
-    if(random == 0)
-        song = "sounds/aquarium.mp3";
-    else if(random == 1)
-        song = "sounds/rafting_starlit_everglades.mp3";
-    else
-        song = "sounds/bob_marley_is_this_love.mp3";
-
-    //start playing music from specified file
+    //start playing music, a new song is picked when one finishes
     player = new QMediaPlayer;
-    player->setMedia(QUrl::fromLocalFile(QFileInfo(song).absoluteFilePath() ) );
-    player->setVolume(50);
-    player->play();
+    connect(player, SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)), this, SLOT(musicEvent(QMediaPlayer::MediaStatus)));
+    playRandomSong();
 
     mjHasBlock = false;
 }
@@ -89,22 +126,84 @@ QGraphicsView* gamewindow::GetGraphicsView(){
  * based on the key that was pressed
  */
 void gamewindow::keyPressEvent(QKeyEvent *event){
+    //pause or unpause the game
+    if (event->key() == Qt::Key_Escape){
+        paused = !paused;
+        if(paused)
+            player->pause();
+        else
+            player->play();
+        updateLoopState();
+        return;
+    }
+
+#ifdef PROFILE_ENABLED
+    //the overlay and the csv dump work while a replay plays too
+    if(event->key() == Qt::Key_F3){
+        profileOverlay->setVisible(!profileOverlay->isVisible());
+        profileOverlay->setText(profiler().overlayText() + "\n" + ginny->poolText());
+        profileOverlay->adjustSize();
+        return;
+    }
+    if(event->key() == Qt::Key_F4){
+        QDir().mkpath("profile");
+        QString fileName = "profile/ticks-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".csv";
+        QString error;
+        if(profiler().writeCsv(fileName, error))
+            std::cout << "wrote " << fileName.toStdString() << "\n";
+        else
+            std::cout << error.toStdString() << "\n";
+        return;
+    }
+#endif
+
+    //a replay is playing the keys
+    if(replaying)
+        return;
+
+    qint64 start = traceLog::now();
+    if (event->key() == Qt::Key_A)
+        pressKey(REPLAY_LEFT);
+    else if(event->key() == Qt::Key_D)
+        pressKey(REPLAY_RIGHT);
+    else if(event->key() == Qt::Key_R)
+        pressKey(REPLAY_RESTART);
+    else if(event->key() == Qt::Key_Space)
+        pressKey(REPLAY_SPACE);
+    else if(event->key() == Qt::Key_P)
+        pressKey(REPLAY_SAVE);
+    checkBudget(start, "key");
+}
+
+/*! \brief gamewindow::pressKey
+ * does what a key does, for the keyboard and for replays. Keys that do something are recorded with the tick
+ * they came on
+ */
+void gamewindow::pressKey(int key){
+    TRACE_SCOPE("key");
     //if it is safe to animate. It is not safe when mj has 0 life and we are reloading the level
-    if(ginny->life<=0)
+    if(ginny->life<=0 || paused)
         return;
 
+    renderPending = true;
+    recording.record(tickCount, key);
+
     //move left
-    if (event->key() == Qt::Key_A)
+    if (key == REPLAY_LEFT){
+        PROFILE_SCOPE(PROFILE_MOVECHAR);
         ginny->moveChar(-1);
+    }
     //move right
-    else if(event->key() == Qt::Key_D)
+    else if(key == REPLAY_RIGHT){
+        PROFILE_SCOPE(PROFILE_MOVECHAR);
         ginny->moveChar(1);
+    }
     //reset the current level
-    else if(event->key() == Qt::Key_R){
+    else if(key == REPLAY_RESTART){
         ginny->startOver();
     }
     //open door or pick up or drop block
-    else if(event->key() == Qt::Key_Space){
+    else if(key == REPLAY_SPACE){
         if(!(ginny->mjHasBlock))
             ginny->getBlock();
         else
@@ -116,7 +215,7 @@ void gamewindow::keyPressEvent(QKeyEvent *event){
         }
     }
     //save game
-    else if(event->key() == Qt::Key_P){
+    else if(key == REPLAY_SAVE){
         if(!ginny->mjHasBlock)
             ginny->saveGame(session);
         else
@@ -124,38 +223,184 @@ void gamewindow::keyPressEvent(QKeyEvent *event){
     }
 }
 
-/*! \brief gamewindow::moveEvent
- * sets up timer function for moving enemies
+/*! \brief gamewindow::closeEvent
+ * keeps the session as replays/last.mjr, a replay that is being watched is not recorded again
+ */
+void gamewindow::closeEvent(QCloseEvent *event){
+    if(playback.level.empty()){
+        recording.finish(tickCount);
+        QDir().mkpath("replays");
+        std::string error;
+        if(!recording.save("replays/last.mjr", error))
+            std::cout << error << "\n";
+    }
+    QMainWindow::closeEvent(event);
+}
+
+/*! \brief gamewindow::changeEvent
+ * stops the game loop while the window is minimized or in the background
+ */
+void gamewindow::changeEvent(QEvent *event){
+    if(event->type() == QEvent::ActivationChange || event->type() == QEvent::WindowStateChange)
+        updateLoopState();
+    QMainWindow::changeEvent(event);
+}
+
+/*! \brief gamewindow::updateLoopState
+ * runs the loop timer only while the game can be played, so a paused game has no wakeups at all
+ */
+void gamewindow::updateLoopState(){
+    bool run = !paused && isActiveWindow() && !isMinimized();
+
+    if(run && !loopTimer->isActive()){
+        //time spent paused does not count
+        accumulator = 0;
+        loopClock.start();
+        loopTimer->start();
+    }
+    else if(!run && loopTimer->isActive()){
+        loopTimer->stop();
+    }
+}
+
+/*! \brief gamewindow::loopEvent
+ * runs as many fixed steps as the time since the last wakeup covers
  */
-void gamewindow::moveEvent(){
-    if(ginny->life<=0)
+void gamewindow::loopEvent(){
+    //a message box from inside a step spins the event loop, don't step again under it
+    if(inStep)
         return;
 
-    ginny->moveEnemies();
-    ginny->moveGood();
+    accumulator += loopClock.restart();
+
+    int steps = 0;
+    while(accumulator >= TICK_MS && steps < MAX_CATCHUP_TICKS){
+        qint64 start = traceLog::now();
+        step();
+        checkBudget(start, "step");
+        accumulator -= TICK_MS;
+        steps++;
+    }
+    //fell too far behind, probably a stall, drop the rest
+    if(accumulator >= TICK_MS)
+        accumulator = 0;
+
+    if(renderPending){
+        followMJ();
+        graphicsView->viewport()->update();
+        renderPending = false;
+    }
 }
 
-/*! \brief gamewindow::moveEvent
- * sets up timer function for media player for music played in the background
+/*! \brief gamewindow::followMJ
+ * keeps mj in the middle of the view on levels bigger than the window, and tells the engine what is in view
  */
-void gamewindow::mediaEvent(){
-    //once song finishes start a new one
-    if(player->mediaStatus() == 8 || player->mediaStatus() == 7){
-        QTime time = QTime::currentTime();
-        qsrand((uint)time.msec());
-        int random = qrand() % (3);
-        QString song;
-        if(random == 0)
-            song = "sounds/aquarium.mp3";
-        else if(random == 1)
-            song = "sounds/rafting_starlit_everglades.mp3";
-        else
-            song = "sounds/bob_marley_is_this_love.mp3";
+void gamewindow::followMJ(){
+    graphicsView->centerOn(ginny->mjCenter());
+    ginny->ShowArea(graphicsView->mapToScene(graphicsView->viewport()->rect()).boundingRect());
+}
 
-        player->setMedia(QUrl::fromLocalFile(song));
-        player->setVolume(50);
-        player->play();
+/*! \brief gamewindow::step
+ * one tick of the game: npcs walk every NPC_TICKS ticks, then collisions are resolved if the simulation has one to check
+ */
+void gamewindow::step(){
+    TRACE_SCOPE("step");
+    inStep = true;
+
+    //the keys of a replay come in between the step they were pressed after and the next one, like the keyboard's do
+    while(replaying && playbackNext < playback.inputs.size() && playback.inputs[playbackNext].tick <= tickCount)
+        pressKey(playback.inputs[playbackNext++].key);
+    if(replaying && playbackNext >= playback.inputs.size() && tickCount >= playback.endTick){
+        std::cout << "replay finished\n";
+        replaying = false;
+    }
+
+    if(ginny->life<=0){
+        inStep = false;
+        return;
+    }
+    tickCount++;
+
+    if(tickCount % NPC_TICKS == 0){
+        {
+            PROFILE_SCOPE(PROFILE_ENEMIES);
+            ginny->moveEnemies();
+        }
+        {
+            PROFILE_SCOPE(PROFILE_GOOD);
+            ginny->moveGood();
+        }
+        renderPending = true;
+    }
+
+    if(ginny->collisionPending()){
+        PROFILE_SCOPE(PROFILE_COLLISIONS);
+        ginny->checkCollisions();
+        renderPending = true;
     }
 
-    ginny->checkCollisions();
+#ifdef PROFILE_ENABLED
+    endProfileTick();
+#endif
+    inStep = false;
+}
+
+/*! \brief gamewindow::endProfileTick
+ * hands the tick to the profiler. Counting the scene's items walks all of them, so that and the overlay only
+ * happen every NPC_TICKS ticks
+ */
+void gamewindow::endProfileTick(){
+    bool sample = tickCount % NPC_TICKS == 0;
+    profiler().endTick(tickCount, sample ? graphicsScene->items().size() : -1);
+    if(sample && profileOverlay->isVisible()){
+        profileOverlay->setText(profiler().overlayText() + "\n" + ginny->poolText());
+        profileOverlay->adjustSize();
+    }
+}
+
+/*! \brief gamewindow::checkBudget
+ * the watchdog: a step or key that took longer than a tick writes what the game did in the last few seconds to
+ * traces/, to open in chrome://tracing or Perfetto
+ */
+void gamewindow::checkBudget(qint64 start, const char *what){
+    qint64 end = traceLog::now();
+    qint64 took = end - start;
+    if(took <= (qint64)TICK_MS*1000000 || (lastTrace != 0 && end - lastTrace < (qint64)TRACE_GAP_MS*1000000))
+        return;
+    lastTrace = end;
+
+    QDir().mkpath("traces");
+    QString fileName = QString("traces/slow-%1-tick%2.json").arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))
+            .arg(tickCount);
+    std::string error;
+    if(traceLog::write(fileName.toStdString(), (qint64)TRACE_WINDOW_MS*1000000, error))
+        std::cout << what << " at tick " << tickCount << " took " << took/1000000 << " ms, wrote " << fileName.toStdString() << "\n";
+    else
+        std::cout << error << "\n";
+}
+
+/*! \brief gamewindow::musicEvent
+ * once song finishes start a new one
+ */
+void gamewindow::musicEvent(QMediaPlayer::MediaStatus status){
+    if(status == QMediaPlayer::EndOfMedia || status == QMediaPlayer::InvalidMedia)
+        playRandomSong();
+}
+
+/*! \brief gamewindow::playRandomSong
+ * picks one of the songs at random and plays it
+ */
+void gamewindow::playRandomSong(){
+    int random = music.below(3);
+    QString song;
+    if(random == 0)
+        song = "sounds/aquarium.mp3";
+    else if(random == 1)
+        song = "sounds/rafting_starlit_everglades.mp3";
+    else
+        song = "sounds/bob_marley_is_this_love.mp3";
+
+    assets().setMedia(player, song);
+    player->setVolume(50);
+    player->play();
 }
@@ -5,6 +5,8 @@
 #include <QtCore>
 #include <QtGui>
 #include "engine.h"
+#include "replay.h"
+#include "gamerandom.h"
 #include "ui_gamewindow.h"
 #include "definitions.h"
 
@@ -19,7 +21,7 @@ class gamewindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit gamewindow(QWidget *parent = 0, bool newGame = true, QString sessionName = NULL);
+    explicit gamewindow(QWidget *parent = 0, bool newGame = true, QString sessionName = NULL, QString replayFile = QString());
     ~gamewindow();
     int left;
     int right;
@@ -29,8 +31,8 @@ public:
 
 
 public slots:
-    void moveEvent();
-    void mediaEvent();
+    void loopEvent();
+    void musicEvent(QMediaPlayer::MediaStatus status);
 
 private:
     Ui::gamewindow *ui;
@@ -40,9 +42,41 @@ private:
     QString session;
     QMediaPlayer *player;
 
+    //fixed timestep loop, one timer drives npcs, collisions and repaints
+    QTimer *loopTimer;
+    QElapsedTimer loopClock;
+    qint64 accumulator;
+    quint64 tickCount;
+    bool paused;
+    bool inStep;
+    bool renderPending;
+
+    //every session is recorded into replays/last.mjr. When a replay is played its keys are pressed by step()
+    //at the ticks they were recorded on and the keyboard only pauses
+    replay recording;
+    replay playback;
+    bool replaying;
+    unsigned int playbackNext;
+    //the songs have their own numbers so they don't change what the game draws
+    gameRandom music;
+    //F3 shows what the ticks cost, see frameprofiler.h
+    QLabel *profileOverlay;
+    //when the watchdog last wrote a trace
+    qint64 lastTrace;
+
+    void step();
+    void pressKey(int key);
+    void updateLoopState();
+    void followMJ();
+    void playRandomSong();
+    void endProfileTick();
+    void checkBudget(qint64 start, const char *what);
+
 //this is needed to listen to keys
 protected:
     void keyPressEvent(QKeyEvent *event);
+    void changeEvent(QEvent *event);
+    void closeEvent(QCloseEvent *event);
 };
 
 #endif // GAMEWINDOW_H
@@ -51,10 +51,8 @@ GraphicsViewEditor::GraphicsViewEditor(engine *gin){
     //this makes sure it isn't shown until it is ready to be shown
     rightClickMenu->hide();
 
-    //finds just the pngs in the sprites incase of accidents
-    QStringList nameFilter("*.png");
-    QDir directory(QString("sprites/"));
-    QStringList spritesList = directory.entryList(nameFilter);
+    //finds just the pngs in the sprites incase of accidents, packed or not
+    QStringList spritesList = assets().list("sprites", ".png");
 
     //Sets up the rightclick menu
     //making enough room to hold all sprites
@@ -90,7 +88,7 @@ GraphicsViewEditor::GraphicsViewEditor(engine *gin){
     for(int i=0; i<rightClickMenu->columnCount(); i++){
         for(int j=0; j<rightClickMenu->rowCount(); j++){
             item = new QTableWidgetItem();
-            ico = new QIcon("sprites/"+spritesList.at(k));
+            ico = new QIcon(assets().pixmap("sprites/"+spritesList.at(k)));
 
             item->setIcon( *ico );
             //item->setText(QString("sprites/"+spritesList.at(k)));
@@ -165,11 +163,12 @@ void GraphicsViewEditor::mouseReleaseEvent(QMouseEvent * event){
 
         //I should have subclasses how the graphicsscene holds items and redid this whole thing,
         //that would have made everything wayyyyyy easier. ohwell
-        if ( ginny->blocks->tail && this->itemAt(event->pos()) ){
-            ginny->blocks->tail->x = (int)floor( this->itemAt(event->pos())->x()/BLOCK_SIZE);
-            ginny->blocks->tail->y = (int)floor( (ginny->GetScene()->height()-( this->itemAt( event->pos())->y())) / BLOCK_SIZE);
-            qDebug() << ginny->blocks->tail->y;
-            qDebug() << ginny->blocks->tail->x;
+        int last = ginny->blocks->getCount() - 1;
+        if ( last >= 0 && this->itemAt(event->pos()) ){
+            ginny->blocks->x[last] = (int)floor( this->itemAt(event->pos())->x()/BLOCK_SIZE);
+            ginny->blocks->y[last] = (int)floor( (ginny->GetScene()->height()-( this->itemAt( event->pos())->y())) / BLOCK_SIZE);
+            qDebug() << ginny->blocks->y[last];
+            qDebug() << ginny->blocks->x[last];
         }
     }
 }
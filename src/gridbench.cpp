@@ -0,0 +1,123 @@
+/*! \abstract gridbench
+ *         Times the questions the movement rules ask about the field (can an npc step forward, does it have to turn around)
+ *         against the old grid of pointers and against the bit rows in the simulation. Both answer the same questions on the
+ *         same random field, and the answers are added up so the two can be checked against each other.
+ */
+
+#include "simulation.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+struct query{
+    int x;
+    int row;
+    int step;
+};
+
+static double seconds(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]){
+    int count = argc > 1 ? atoi(argv[1]) : 10000000;
+    int fill = argc > 2 ? atoi(argv[2]) : 30;
+    int width = argc > 3 ? atoi(argv[3]) : GRID_WIDTH;
+    int height = argc > 4 ? atoi(argv[4]) : GRID_HEIGHT;
+    srand(1);
+
+    //random field, the pointer grid is laid out like the old engine::walkable
+    simulation sim;
+    sim.clear(width, height);
+    std::vector<const void*> walkable(width*height, (const void*)NULL);
+    static int blockTag;
+    for(int row = 0; row < height; row++){
+        for(int x = 0; x < width; x++){
+            if(rand() % 100 < fill){
+                sim.addEntity(KIND_BLOCK, x, row + 1);
+                walkable[row*width + x] = &blockTag;
+            }
+        }
+    }
+
+    std::vector<query> queries(count);
+    for(int i = 0; i < count; i++){
+        queries[i].x = rand() % width;
+        queries[i].row = rand() % height;
+        queries[i].step = rand() % 2 ? 1 : -1;
+    }
+
+    //the old way, one pointer compared to NULL per neighbour
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long ptrWalk = 0, ptrTurn = 0;
+    for(int i = 0; i < count; i++){
+        const query &q = queries[i];
+        int nx = q.x + q.step;
+        int bx = q.x - q.step;
+        bool ahead = nx >= 0 && nx < width;
+        bool behind = bx >= 0 && bx < width;
+        if(ahead && q.row > 0 && walkable[(q.row - 1)*width + nx] != NULL && walkable[q.row*width + nx] == NULL)
+            ptrWalk++;
+        else if(behind && q.row > 0 && walkable[(q.row - 1)*width + bx] != NULL)
+            ptrTurn++;
+    }
+    double ptrTime = seconds(start);
+
+    //bit rows, one shift and mask per question. the padding around the field makes the edge checks
+    //unnecessary, they are kept so both loops do the same work
+    start = std::chrono::steady_clock::now();
+    long bitWalk = 0, bitTurn = 0;
+    for(int i = 0; i < count; i++){
+        const query &q = queries[i];
+        int nx = q.x + q.step;
+        int bx = q.x - q.step;
+        bool ahead = nx >= 0 && nx < width;
+        bool behind = bx >= 0 && bx < width;
+        if(ahead && simulation::rowBit(sim.standableRow(q.row), nx))
+            bitWalk++;
+        else if(behind && simulation::rowBit(sim.solidRow(q.row - 1), bx))
+            bitTurn++;
+    }
+    double bitTime = seconds(start);
+
+    //a whole row at once, how many cells of every row can be stood on
+    int rowPasses = count / height;
+    start = std::chrono::steady_clock::now();
+    long ptrRows = 0;
+    for(int pass = 0; pass < rowPasses; pass++){
+        int row = pass % height;
+        for(int x = 0; x < width; x++){
+            if(row > 0 && walkable[(row - 1)*width + x] != NULL && walkable[row*width + x] == NULL)
+                ptrRows++;
+        }
+    }
+    double ptrRowTime = seconds(start);
+
+    start = std::chrono::steady_clock::now();
+    long bitRows = 0;
+    for(int pass = 0; pass < rowPasses; pass++){
+        const rowBits *walk = sim.standableRow(pass % height);
+        for(int w = 0; w < sim.rowWords(); w++){
+            rowBits bits = walk[w];
+            while(bits){
+                bits &= bits - 1;
+                bitRows++;
+            }
+        }
+    }
+    double bitRowTime = seconds(start);
+
+    printf("%dx%d field, %d cell queries, %d%% blocks\n", width, height, count, fill);
+    printf("pointer grid  %8.2f Mq/s  walk %ld turn %ld\n", count / ptrTime / 1e6, ptrWalk, ptrTurn);
+    printf("bit rows      %8.2f Mq/s  walk %ld turn %ld\n", count / bitTime / 1e6, bitWalk, bitTurn);
+    printf("%d row queries\n", rowPasses);
+    printf("pointer grid  %8.2f Mrows/s  standable %ld\n", rowPasses / ptrRowTime / 1e6, ptrRows);
+    printf("bit rows      %8.2f Mrows/s  standable %ld\n", rowPasses / bitRowTime / 1e6, bitRows);
+
+    if(ptrWalk != bitWalk || ptrTurn != bitTurn || ptrRows != bitRows){
+        printf("answers differ\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+#times the bit rows against the old pointer grid, run it with a query count, the percent of cells that are blocks and the field size
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(core.pri)
+
+SOURCES += \
+    gridbench.cpp
+
+TARGET = gridbench
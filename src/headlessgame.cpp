@@ -0,0 +1,171 @@
+/*! \abstract headlessGame
+ *         Runs the game without a window, for replays and tools. Each method stands for a part of gamewindow or engine and
+ *         follows it call for call: press is gamewindow::keyPressEvent, step is gamewindow::step and reset is engine::reset.
+ *         A change to the game loop has to be made in both places or replays stop matching.
+ */
+
+#include "headlessgame.h"
+
+headlessGame::headlessGame(uint32_t seed) : random(seed){
+    tickCount = 0;
+    loadCount = 0;
+    life = 0;
+    level = NULL;
+    next = "levels/defaultlevel";
+    current = "levels/defaultlevel";
+    playing = NULL;
+    nextInput = 0;
+}
+
+/*! \brief headlessGame::load
+ *  loads a level like engine::loadGame, false with error set if it can't be read
+ */
+bool headlessGame::load(const std::string &levelName, std::string &error){
+    std::map<std::string, levelFile>::iterator found = levels.find(levelName);
+    if(found == levels.end()){
+        levelFile file;
+        if(!file.read(levelName, error))
+            return false;
+        found = levels.insert(std::make_pair(levelName, file)).first;
+    }
+    level = &found->second;
+    if(!level->next.empty())
+        next = level->next;
+    if(!level->current.empty())
+        current = level->current;
+    level->addTo(sim, true, random);
+    loaded = levelName;
+    loadCount++;
+    life = level->lives;
+    return true;
+}
+
+/*! \brief headlessGame::reset
+ *  engine::reset without the complaints it prints. A level that can't be read stops the game here, the engine
+ *  would go on with an empty field
+ */
+void headlessGame::reset(std::string levelName){
+    std::string error;
+    if(!levelName.empty())
+        load(levelName, error);
+}
+
+/*! \brief headlessGame::mirrorEvents
+ *  the parts of engine::mirrorEvents that change the game, the rest only draws
+ */
+void headlessGame::mirrorEvents(){
+    const std::vector<SimEvent> &events = sim.events();
+    for(unsigned int i = 0; i < events.size(); i++){
+        if(events[i].type == EVENT_HURT)
+            life--;
+        else if(events[i].type == EVENT_DIED){
+            reset(current);
+            return;
+        }
+    }
+    life = sim.lives();
+}
+
+/*! \brief headlessGame::press
+ *  gamewindow::keyPressEvent, saving is left out
+ */
+void headlessGame::press(int key){
+    if(life <= 0)
+        return;
+
+    sim.clearEvents();
+    if(key == REPLAY_LEFT || key == REPLAY_RIGHT){
+        sim.moveChar(key == REPLAY_LEFT ? -1 : 1);
+        mirrorEvents();
+    }
+    else if(key == REPLAY_RESTART){
+        life = 0;
+        reset(current);
+    }
+    else if(key == REPLAY_SPACE){
+        if(!sim.mjHasBlock())
+            sim.getBlock();
+        else
+            sim.dropBlock();
+        mirrorEvents();
+
+        if(sim.itemCount() <= 0 && sim.mjAtDoor()){
+            life = 0;
+            reset(next);
+        }
+    }
+}
+
+/*! \brief headlessGame::step
+ *  gamewindow::step
+ */
+void headlessGame::step(){
+    if(life <= 0)
+        return;
+
+    tickCount++;
+    if(tickCount % NPC_TICKS == 0){
+        sim.clearEvents();
+        sim.moveEnemies();
+        mirrorEvents();
+        sim.clearEvents();
+        sim.moveGood();
+        mirrorEvents();
+    }
+
+    if(sim.collisionPending()){
+        sim.clearEvents();
+        sim.checkCollisions();
+        mirrorEvents();
+    }
+}
+
+/*! \brief headlessGame::play
+ *  loads the replay's level and runs it, a key recorded at tick t is pressed after step t
+ */
+bool headlessGame::play(const replay &session, std::string &error){
+    if(!begin(session, error))
+        return false;
+    while(advance())
+        ;
+    return true;
+}
+
+/*! \brief headlessGame::begin
+ *  checks the replay was made on the level as it is now and loads it
+ */
+bool headlessGame::begin(const replay &session, std::string &error){
+    std::map<std::string, uint64_t>::iterator known = levelHashes.find(session.level);
+    if(known == levelHashes.end()){
+        uint64_t hash;
+        if(!replay::hashFile(session.level, hash)){
+            error = session.level + ": can not open";
+            return false;
+        }
+        known = levelHashes.insert(std::make_pair(session.level, hash)).first;
+    }
+    if(known->second != session.levelHash){
+        error = session.level + ": level changed since the replay was recorded";
+        return false;
+    }
+
+    random.setSeed(session.seed);
+    next = "levels/defaultlevel";
+    current = "levels/defaultlevel";
+    tickCount = 0;
+    loadCount = 0;
+    playing = &session;
+    nextInput = 0;
+    return load(session.level, error);
+}
+
+bool headlessGame::advance(){
+    const std::vector<replayInput> &inputs = playing->inputs;
+    while(nextInput < inputs.size() && inputs[nextInput].tick <= tickCount)
+        press(inputs[nextInput++].key);
+    //with no lives the window stops stepping too, nothing more can happen
+    if(tickCount >= playing->endTick || life <= 0)
+        return false;
+    step();
+    return true;
+}
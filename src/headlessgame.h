@@ -0,0 +1,56 @@
+#ifndef HEADLESSGAME_H
+#define HEADLESSGAME_H
+
+#include "gamerandom.h"
+#include "levelfile.h"
+#include "replay.h"
+#include "simulation.h"
+#include <map>
+#include <string>
+
+/* the game window and the engine without the window: keys, ticks, restarts and the next level, as plain calls
+   on the simulation. It makes the same calls in the same order, so it ends up where the game would */
+class headlessGame
+{
+public:
+    headlessGame(uint32_t seed);
+
+    bool load(const std::string &levelName, std::string &error);
+    void press(int key);
+    void step();
+    //plays a whole replay from its level up to its end tick
+    bool play(const replay &session, std::string &error);
+    //the same a tick at a time: begin loads the level, advance presses the keys that are due and steps once,
+    //false once the replay is over. session has to stay around until then
+    bool begin(const replay &session, std::string &error);
+    bool advance();
+
+    const simulation &state() const { return sim; }
+    uint64_t ticks() const { return tickCount; }
+    //levels loaded so far, restarts included
+    int loads() const { return loadCount; }
+    const std::string &levelName() const { return loaded; }
+
+private:
+    simulation sim;
+    //levels are read once and kept, restarts and replays played over and over don't touch the disk again
+    std::map<std::string, levelFile> levels;
+    std::map<std::string, uint64_t> levelHashes;
+    const levelFile *level;
+    //parser::nextLevel and parser::curLevel: a level without NEXT or CURRENT keeps the ones from before it
+    std::string next;
+    std::string current;
+    gameRandom random;
+    std::string loaded;
+    uint64_t tickCount;
+    int loadCount;
+    //engine::life, it is 0 while a level loads and stays 0 if the level can't be loaded
+    int life;
+    const replay *playing;
+    unsigned int nextInput;
+
+    void reset(std::string levelName);
+    void mirrorEvents();
+};
+
+#endif // HEADLESSGAME_H
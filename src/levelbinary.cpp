@@ -0,0 +1,324 @@
+/*! \abstract levelBinary
+ *         Levels compiled by levelc so loading one is a map and a check instead of a parse: a header with the size, the
+ *         lives and the next level, every entity as a 20 byte record grouped by the list the engine keeps it in, the
+ *         sprite names once each in a string table and a bitmap of the solid cells. levelFile and the parser use a
+ *         compiled level in place of the text when it is there and not older than the text.
+ */
+
+#include "levelbinary.h"
+#include "levelfile.h"
+#include "levelscanner.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+//the format is written and mapped as is, these are what every compiler we build with gives
+static_assert(sizeof(levelRecord) == 20, "levelRecord has to be 20 bytes");
+static_assert(sizeof(levelBinaryHeader) == 68, "levelBinaryHeader has to be 68 bytes");
+
+static uint32_t intern(std::map<std::string, uint32_t> &ids, std::vector<std::string> &names, const std::string &s){
+    std::map<std::string, uint32_t>::iterator found = ids.find(s);
+    if(found != ids.end())
+        return found->second;
+    ids[s] = (uint32_t)names.size();
+    names.push_back(s);
+    return ids[s];
+}
+
+//the group a keyword's records go in
+static int groupOf(int keyword){
+    if(keyword == LEVEL_MJ || keyword == LEVEL_GOOD)
+        return GROUP_GOOD;
+    if(keyword == LEVEL_ENEMY)
+        return GROUP_ENEMY;
+    if(keyword == LEVEL_BLOCK || keyword == LEVEL_MBLOCK)
+        return GROUP_BLOCK;
+    if(keyword == LEVEL_DOOR)
+        return GROUP_DOOR;
+    return GROUP_OTHER;
+}
+
+levelBinary::levelBinary(){
+    data = NULL;
+    size = 0;
+    mapped = NULL;
+    head = NULL;
+}
+
+levelBinary::~levelBinary(){
+    close();
+}
+
+void levelBinary::close(){
+#ifndef _WIN32
+    if(mapped != NULL)
+        munmap(mapped, size);
+#endif
+    mapped = NULL;
+    copy.clear();
+    data = NULL;
+    size = 0;
+    head = NULL;
+}
+
+/*! \brief levelBinary::open
+ *  maps the file where there is mmap, reads it where there isn't
+ */
+bool levelBinary::open(const std::string &fileName, std::string &error){
+    close();
+#ifndef _WIN32
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if(fd < 0){
+        error = fileName + ": can not open";
+        return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) == 0 && info.st_size > 0){
+        void *p = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED){
+            mapped = p;
+            size = info.st_size;
+        }
+    }
+    ::close(fd);
+    if(mapped != NULL){
+        if(use((const char*)mapped, size, error))
+            return true;
+        error = fileName + ": " + error;
+        close();
+        return false;
+    }
+#endif
+
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    if(!in){
+        error = fileName + ": can not open";
+        return false;
+    }
+    copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if(copy.empty() || !use(&copy[0], copy.size(), error)){
+        error = fileName + ": " + (copy.empty() ? std::string("empty") : error);
+        std::vector<char>().swap(copy);
+        return false;
+    }
+    return true;
+}
+
+/*! \brief levelBinary::use
+ *  checks every offset, count and string index, so a broken or hostile file is turned down here and nothing
+ *  after has to check again
+ */
+bool levelBinary::use(const char *data, size_t size, std::string &error){
+    if(size < sizeof(levelBinaryHeader) || memcmp(data, LEVELBIN_MAGIC, 4) != 0){
+        error = "not a compiled level";
+        return false;
+    }
+    const levelBinaryHeader *h = (const levelBinaryHeader*)data;
+    if(h->version != LEVELBIN_VERSION){
+        error = "compiled level version " + std::to_string(h->version) + ", this build reads " + std::to_string(LEVELBIN_VERSION);
+        return false;
+    }
+    if(!levelScanner::sizeFits(h->width, h->height)){
+        error = "bad size";
+        return false;
+    }
+    if(h->lives < 1 || h->lives > LEVEL_MAX_LIVES){
+        error = "bad lives";
+        return false;
+    }
+
+    uint64_t records = 0;
+    for(int g = 0; g < GROUP_COUNT; g++)
+        records += h->groupCount[g];
+    uint64_t solidBytes = ((uint64_t)h->width*h->height + 7)/8;
+    if(h->recordsOffset % 4 != 0 || h->recordsOffset < sizeof(levelBinaryHeader) ||
+       h->recordsOffset + records*sizeof(levelRecord) > size ||
+       h->stringsOffset % 4 != 0 || h->stringsOffset + (uint64_t)h->stringCount*4 + h->stringBytes > size ||
+       h->stringBytes == 0 || h->solidOffset + solidBytes > size){
+        error = "truncated";
+        return false;
+    }
+
+    const uint32_t *stringOffsets = (const uint32_t*)(data + h->stringsOffset);
+    const char *stringText = data + h->stringsOffset + h->stringCount*4;
+    if(stringText[h->stringBytes - 1] != 0 || h->next >= h->stringCount || h->current >= h->stringCount){
+        error = "bad string table";
+        return false;
+    }
+    for(uint32_t s = 0; s < h->stringCount; s++){
+        if(stringOffsets[s] >= h->stringBytes){
+            error = "bad string table";
+            return false;
+        }
+    }
+
+    const levelRecord *r = (const levelRecord*)(data + h->recordsOffset);
+    for(int g = 0; g < GROUP_COUNT; g++){
+        groupStart[g] = r;
+        for(uint32_t i = 0; i < h->groupCount[g]; i++, r++){
+            bool extra = r->keyword == LEVEL_GOOD || r->keyword == LEVEL_OTHER;
+            if(r->keyword > LEVEL_OTHER || groupOf(r->keyword) != g || r->sprite >= h->stringCount ||
+               (extra && r->extra >= h->stringCount)){
+                error = "bad record " + std::to_string(i) + " in group " + std::to_string(g);
+                return false;
+            }
+        }
+    }
+
+    this->data = data;
+    this->size = size;
+    head = h;
+    offsets = stringOffsets;
+    strings = stringText;
+    solidBits = (const unsigned char*)(data + h->solidOffset);
+    return true;
+}
+
+bool levelBinary::solid(int x, int y) const{
+    if(x < 0 || x >= head->width || y < 1 || y > head->height)
+        return false;
+    uint64_t bit = (uint64_t)(y - 1)*head->width + x;
+    return (solidBits[bit >> 3] >> (bit & 7)) & 1;
+}
+
+const char *levelBinary::typeName(const levelRecord &r) const{
+    if(r.keyword == LEVEL_OTHER)
+        return string(r.extra);
+    return levelScanner::keywordName((LevelKeyword)r.keyword);
+}
+
+/*! \brief levelBinary::toLevel
+ *  the level as levelFile::read gives it, entries in group order, which addTo and the engine see the same as the
+ *  order of the text
+ */
+void levelBinary::toLevel(levelFile &level) const{
+    level = levelFile();
+    level.width = head->width;
+    level.height = head->height;
+    level.lives = head->lives;
+    level.next = string(head->next);
+    level.current = string(head->current);
+
+    uint32_t total = 0;
+    for(int g = 0; g < GROUP_COUNT; g++)
+        total += count(g);
+    level.entries.reserve(total);
+    for(int g = 0; g < GROUP_COUNT; g++){
+        for(int i = 0; i < count(g); i++){
+            const levelRecord &r = record(g, i);
+            levelEntry entry;
+            entry.keyword = (LevelKeyword)r.keyword;
+            entry.type = typeName(r);
+            entry.sprite = string(r.sprite);
+            entry.x = r.x;
+            entry.y = r.y;
+            entry.goodObj = r.keyword == LEVEL_GOOD ? string(r.extra) : "";
+            entry.hasObj = r.hasObj != 0;
+            level.entries.push_back(entry);
+        }
+    }
+}
+
+/*! \brief levelBinary::compile
+ *  the compiled form of a level read from text
+ */
+void levelBinary::compile(const levelFile &level, std::vector<char> &out){
+    std::map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+
+    levelBinaryHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, LEVELBIN_MAGIC, 4);
+    h.version = LEVELBIN_VERSION;
+    h.width = level.width;
+    h.height = level.height;
+    h.lives = level.lives;
+    h.next = intern(ids, names, level.next);
+    h.current = intern(ids, names, level.current);
+
+    //strings are numbered in group order, so a decompiled level compiles back to the same bytes
+    std::vector<const levelEntry*> grouped[GROUP_COUNT];
+    for(unsigned int e = 0; e < level.entries.size(); e++){
+        const levelEntry &entry = level.entries[e];
+        grouped[groupOf(entry.keyword)].push_back(&entry);
+    }
+
+    std::vector<levelRecord> groups[GROUP_COUNT];
+    std::vector<unsigned char> solid(((size_t)level.width*level.height + 7)/8, 0);
+    for(int g = 0; g < GROUP_COUNT; g++){
+        for(unsigned int e = 0; e < grouped[g].size(); e++){
+            const levelEntry &entry = *grouped[g][e];
+            LevelKeyword keyword = entry.keyword;
+            levelRecord r;
+            memset(&r, 0, sizeof(r));
+            r.x = entry.x;
+            r.y = entry.y;
+            r.sprite = intern(ids, names, entry.sprite);
+            r.keyword = keyword;
+            r.hasObj = entry.hasObj ? 1 : 0;
+            if(keyword == LEVEL_GOOD)
+                r.extra = intern(ids, names, entry.goodObj);
+            else if(keyword == LEVEL_OTHER)
+                r.extra = intern(ids, names, entry.type);
+            groups[g].push_back(r);
+
+            if((keyword == LEVEL_BLOCK || keyword == LEVEL_MBLOCK) && entry.x >= 0 && entry.x < level.width &&
+               entry.y >= 1 && entry.y <= level.height){
+                size_t bit = (size_t)(entry.y - 1)*level.width + entry.x;
+                solid[bit >> 3] |= 1 << (bit & 7);
+            }
+        }
+    }
+
+    std::vector<uint32_t> offsets;
+    std::string text;
+    for(unsigned int s = 0; s < names.size(); s++){
+        offsets.push_back((uint32_t)text.size());
+        text += names[s];
+        text += '\0';
+    }
+    while(text.size() % 4 != 0)
+        text += '\0';
+
+    size_t records = 0;
+    for(int g = 0; g < GROUP_COUNT; g++){
+        h.groupCount[g] = (uint32_t)groups[g].size();
+        records += groups[g].size();
+    }
+    h.recordsOffset = sizeof(h);
+    h.stringCount = (uint32_t)names.size();
+    h.stringsOffset = (uint32_t)(h.recordsOffset + records*sizeof(levelRecord));
+    h.stringBytes = (uint32_t)text.size();
+    h.solidOffset = h.stringsOffset + h.stringCount*4 + h.stringBytes;
+
+    out.assign(h.solidOffset + solid.size(), 0);
+    memcpy(&out[0], &h, sizeof(h));
+    size_t at = h.recordsOffset;
+    for(int g = 0; g < GROUP_COUNT; g++){
+        if(!groups[g].empty())
+            memcpy(&out[at], &groups[g][0], groups[g].size()*sizeof(levelRecord));
+        at += groups[g].size()*sizeof(levelRecord);
+    }
+    if(!offsets.empty())
+        memcpy(&out[h.stringsOffset], &offsets[0], offsets.size()*4);
+    memcpy(&out[h.stringsOffset + h.stringCount*4], text.data(), text.size());
+    if(!solid.empty())
+        memcpy(&out[h.solidOffset], &solid[0], solid.size());
+}
+
+bool levelBinary::usable(const std::string &textName){
+    struct stat binary;
+    struct stat text;
+    if(stat(binaryName(textName).c_str(), &binary) != 0)
+        return false;
+    if(stat(textName.c_str(), &text) != 0)
+        return true;
+    return binary.st_mtime >= text.st_mtime;
+}
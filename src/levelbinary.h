@@ -0,0 +1,95 @@
+#ifndef LEVELBINARY_H
+#define LEVELBINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct levelFile;
+
+#define LEVELBIN_MAGIC "MJLB"
+#define LEVELBIN_VERSION ( 1 )
+//a compiled level sits next to its text, levels/levelone.txt compiles to levels/levelone.txt.mjl
+#define LEVELBIN_SUFFIX ".mjl"
+
+/* records are grouped the way the engine keeps its lists, so the order inside each list is the order of the text */
+enum LevelGroup{
+    GROUP_GOOD,      //MJ and GOOD
+    GROUP_ENEMY,
+    GROUP_BLOCK,     //BLOCK and MBLOCK
+    GROUP_DOOR,
+    GROUP_OTHER,     //BACKGROUND and scenery
+    GROUP_COUNT
+};
+
+/* one entity, 20 bytes. Strings are indexes into the string table */
+struct levelRecord{
+    int32_t x;
+    int32_t y;
+    uint32_t sprite;
+    uint32_t extra;       //GOOD: the item, anything the scanner doesn't know: its type
+    uint8_t keyword;      //LevelKeyword
+    uint8_t hasObj;
+    uint16_t reserved;
+};
+
+/* the file starts with this, little endian like everything after it */
+struct levelBinaryHeader{
+    char magic[4];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t lives;
+    uint32_t next;        //string index
+    uint32_t current;
+    uint32_t stringCount;
+    uint32_t stringsOffset;   //stringCount offsets into the text that follows them, each string ends with a 0
+    uint32_t stringBytes;
+    uint32_t groupCount[GROUP_COUNT];
+    uint32_t recordsOffset;   //all groups one after the other
+    uint32_t solidOffset;     //a bit per cell, row y - 1 of x at bit (y - 1)*width + x, set under BLOCK and MBLOCK
+};
+
+/* a compiled level, mapped and used where it lies. Everything is checked once in open(), after that the
+   accessors trust it */
+class levelBinary
+{
+public:
+    levelBinary();
+    ~levelBinary();
+
+    bool open(const std::string &fileName, std::string &error);
+    //checks and uses data, which has to stay around as long as this does
+    bool use(const char *data, size_t size, std::string &error);
+
+    const levelBinaryHeader &header() const { return *head; }
+    int count(int group) const { return head->groupCount[group]; }
+    const levelRecord &record(int group, int i) const { return groupStart[group][i]; }
+    const char *string(uint32_t index) const { return strings + offsets[index]; }
+    bool solid(int x, int y) const;
+    //the type as the text has it
+    const char *typeName(const levelRecord &r) const;
+
+    void toLevel(levelFile &level) const;
+    static void compile(const levelFile &level, std::vector<char> &out);
+
+    static std::string binaryName(const std::string &textName) { return textName + LEVELBIN_SUFFIX; }
+    //true if the level has a compiled file that is not older than its text, or only the compiled file
+    static bool usable(const std::string &textName);
+
+private:
+    const char *data;
+    size_t size;
+    void *mapped;
+    std::vector<char> copy;
+    const levelBinaryHeader *head;
+    const levelRecord *groupStart[GROUP_COUNT];
+    const uint32_t *offsets;
+    const char *strings;
+    const unsigned char *solidBits;
+
+    void close();
+};
+
+#endif // LEVELBINARY_H
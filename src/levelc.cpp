@@ -0,0 +1,180 @@
+/*! \abstract levelc
+ *         Compiles levels to the binary form the game, the editor and the tools load in place of the text, and back.
+ *
+ *         levelc level...              writes level.mjl next to each level, compiled files given are skipped
+ *         levelc -d level.mjl [out]    writes the compiled level back out as text, to out or to the name without .mjl
+ *         levelc -check level...       compiles each level, decompiles it and compiles that again and checks the two
+ *                                      compiled files are the same, the game starts the same from text and compiled
+ *                                      and the solid bitmap is what the blocks make
+ *
+ *         Compiled levels are only used while they are not older than their text, run levelc again after editing one.
+ */
+
+#include "levelbinary.h"
+#include "levelfile.h"
+#include "simulation.h"
+#include "gamerandom.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+static void usage(){
+    printf("levelc level...\nlevelc -d level%s [out]\nlevelc -check level...\n", LEVELBIN_SUFFIX);
+}
+
+static bool endsWith(const std::string &s, const std::string &end){
+    return s.size() >= end.size() && s.compare(s.size() - end.size(), end.size(), end) == 0;
+}
+
+static bool writeBytes(const std::string &fileName, const std::vector<char> &bytes, std::string &error){
+    std::ofstream out(fileName.c_str(), std::ios::binary);
+    out.write(&bytes[0], bytes.size());
+    if(!out){
+        error = fileName + ": can not write";
+        return false;
+    }
+    return true;
+}
+
+//the hash of the game right after the level is loaded, what the replays and the solver start from
+static unsigned long long startHash(const levelFile &level){
+    simulation sim;
+    gameRandom random;
+    level.addTo(sim, true, random);
+    return sim.stateHash();
+}
+
+static bool compileLevel(const std::string &textName){
+    levelFile level;
+    std::string error;
+    if(!level.readText(textName, error)){
+        printf("%s\n", error.c_str());
+        return false;
+    }
+    for(unsigned int w = 0; w < level.warnings.size(); w++)
+        printf("%s\n", level.warnings[w].c_str());
+
+    std::vector<char> bytes;
+    levelBinary::compile(level, bytes);
+    if(!writeBytes(levelBinary::binaryName(textName), bytes, error)){
+        printf("%s\n", error.c_str());
+        return false;
+    }
+    printf("%s: %u entities, %u bytes\n", levelBinary::binaryName(textName).c_str(),
+           (unsigned int)level.entries.size(), (unsigned int)bytes.size());
+    return true;
+}
+
+static bool decompileLevel(const std::string &binaryName, std::string textName){
+    if(textName.empty()){
+        if(!endsWith(binaryName, LEVELBIN_SUFFIX)){
+            printf("%s: give a name to write to\n", binaryName.c_str());
+            return false;
+        }
+        textName = binaryName.substr(0, binaryName.size() - strlen(LEVELBIN_SUFFIX));
+    }
+    levelBinary binary;
+    levelFile level;
+    std::string error;
+    if(!binary.open(binaryName, error)){
+        printf("%s\n", error.c_str());
+        return false;
+    }
+    binary.toLevel(level);
+    if(!level.write(textName, error)){
+        printf("%s\n", error.c_str());
+        return false;
+    }
+    printf("%s\n", textName.c_str());
+    return true;
+}
+
+static bool checkLevel(const std::string &textName){
+    levelFile text;
+    std::string error;
+    if(!text.readText(textName, error)){
+        printf("%s\n", error.c_str());
+        return false;
+    }
+    std::vector<char> first;
+    levelBinary::compile(text, first);
+
+    levelBinary binary;
+    if(!binary.use(&first[0], first.size(), error)){
+        printf("%s: compiled level does not check: %s\n", textName.c_str(), error.c_str());
+        return false;
+    }
+    levelFile fromBinary;
+    binary.toLevel(fromBinary);
+
+    //through text once more, the scanner has to read back what write() wrote
+    std::string roundName = textName + ".levelc-check";
+    levelFile again;
+    bool wrote = fromBinary.write(roundName, error) && again.readText(roundName, error);
+    remove(roundName.c_str());
+    if(!wrote){
+        printf("%s\n", error.c_str());
+        return false;
+    }
+    std::vector<char> second;
+    levelBinary::compile(again, second);
+
+    bool ok = true;
+    if(first != second){
+        printf("%s: compiling the decompiled level gives different bytes\n", textName.c_str());
+        ok = false;
+    }
+    if(startHash(text) != startHash(fromBinary)){
+        printf("%s: the game starts differently from the compiled level\n", textName.c_str());
+        ok = false;
+    }
+
+    simulation sim;
+    gameRandom random;
+    fromBinary.addTo(sim, false, random);
+    for(int row = 0; row < sim.height() && ok; row++){
+        const rowBits *solid = sim.solidRow(row);
+        for(int x = 0; x < sim.width(); x++){
+            if(simulation::rowBit(solid, x) != binary.solid(x, row + 1)){
+                printf("%s: solid bitmap is wrong at %d, %d\n", textName.c_str(), x, row + 1);
+                ok = false;
+                break;
+            }
+        }
+    }
+    if(ok)
+        printf("%s: ok, %u entities, %u strings\n", textName.c_str(), (unsigned int)text.entries.size(),
+               binary.header().stringCount);
+    return ok;
+}
+
+int main(int argc, char *argv[]){
+    if(argc < 2){
+        usage();
+        return 1;
+    }
+
+    if(strcmp(argv[1], "-d") == 0){
+        if(argc < 3 || argc > 4){
+            usage();
+            return 1;
+        }
+        return decompileLevel(argv[2], argc == 4 ? argv[3] : "") ? 0 : 1;
+    }
+
+    bool check = strcmp(argv[1], "-check") == 0;
+    int failed = 0;
+    for(int a = check ? 2 : 1; a < argc; a++){
+        std::string name = argv[a];
+        if(name[0] == '-'){
+            usage();
+            return 1;
+        }
+        //levelc levels/* picks up the compiled files too
+        if(endsWith(name, LEVELBIN_SUFFIX))
+            continue;
+        if(!(check ? checkLevel(name) : compileLevel(name)))
+            failed++;
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#compiles levels to the binary form the game loads faster, and back to text
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+include(core.pri)
+SOURCES += levelc.cpp
+TARGET = levelc
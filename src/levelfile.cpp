@@ -0,0 +1,160 @@
+/*! \abstract levelFile
+ *         Reads a level file with the same scanner the parser uses, but into plain structs so the solver and the other tools
+ *         can load levels without Qt. addTo puts the level into a simulation in the order the engine uses, so entity ids
+ *         match the ones the game gives out.
+ */
+
+#include "levelfile.h"
+#include "simulation.h"
+#include "gamerandom.h"
+#include "levelscanner.h"
+#include "levelbinary.h"
+#include <algorithm>
+#include <fstream>
+
+levelFile::levelFile(){
+    width = GRID_WIDTH;
+    height = GRID_HEIGHT;
+    lives = 3;
+}
+
+/*! \brief levelFile::read
+ *  uses the compiled level next to the text if there is one that is up to date, the text if there isn't or it is
+ *  broken
+ */
+bool levelFile::read(const std::string &fileName, std::string &error){
+    std::string binaryError;
+    if(levelBinary::usable(fileName)){
+        levelBinary binary;
+        if(binary.open(levelBinary::binaryName(fileName), binaryError)){
+            binary.toLevel(*this);
+            return true;
+        }
+    }
+    if(!readText(fileName, error))
+        return false;
+    if(!binaryError.empty())
+        warnings.insert(warnings.begin(), binaryError + ", read the text instead");
+    return true;
+}
+
+/*! \brief levelFile::readText
+ *  reads the level through levelScanner. Returns false with error set if the file can't be opened, lines that make
+ *  no sense are left out and listed in warnings
+ */
+bool levelFile::readText(const std::string &fileName, std::string &error){
+    std::ifstream in(fileName.c_str(), std::ios::binary);
+    if(!in){
+        error = fileName + ": can not open";
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    std::streamoff size = in.tellg();
+    if(size < 0){
+        error = fileName + ": can not read";
+        return false;
+    }
+    std::string text((size_t)size, '\0');
+    in.seekg(0, std::ios::beg);
+    in.read(&text[0], text.size());
+
+    *this = levelFile();
+    entries.reserve(std::count(text.begin(), text.end(), '\n') + 1);
+    levelScanner scanner(text.data(), text.size());
+    levelLine line;
+    while(scanner.next(line)){
+        if(line.keyword == LEVEL_NEXT)
+            next = line.text.str();
+        else if(line.keyword == LEVEL_CURRENT)
+            current = line.text.str();
+        else if(line.keyword == LEVEL_LIVES)
+            lives = line.x;
+        else if(line.keyword == LEVEL_SIZE){
+            width = line.x;
+            height = line.y;
+        }
+        else{
+            levelEntry entry;
+            entry.keyword = line.keyword;
+            entry.type = line.type.str();
+            entry.sprite = line.text.str();
+            entry.x = line.x;
+            entry.y = line.y;
+            entry.goodObj = line.item.str();
+            //same as the parser, only a 1 means the good guy still holds the item
+            entry.hasObj = line.keyword == LEVEL_GOOD && line.hasItem == 1;
+            entries.push_back(entry);
+        }
+    }
+    for(unsigned int e = 0; e < scanner.errors.size(); e++)
+        warnings.push_back(fileName + ": " + scanner.errors[e]);
+    return true;
+}
+
+/*! \brief levelFile::write
+ *  the level as text the scanner reads back the same, for levelc to decompile with
+ */
+bool levelFile::write(const std::string &fileName, std::string &error) const{
+    std::ofstream out(fileName.c_str());
+    if(!out){
+        error = fileName + ": can not write";
+        return false;
+    }
+    out << "LIVES, " << lives << "\n";
+    if(!next.empty())
+        out << "NEXT, " << next << "\n";
+    if(!current.empty())
+        out << "CURRENT, " << current << "\n";
+    out << "SIZE, " << width << ", " << height << "\n";
+    for(unsigned int i = 0; i < entries.size(); i++){
+        const levelEntry &e = entries[i];
+        out << e.type << ", " << e.sprite;
+        if(e.keyword == LEVEL_GOOD)
+            out << ", " << e.x << ", " << e.y << ", " << e.goodObj << ", " << (e.hasObj ? 1 : 0);
+        else if(e.keyword != LEVEL_BACKGROUND)
+            out << ", " << e.x << ", " << e.y;
+        out << "\n";
+    }
+    if(!out){
+        error = fileName + ": can not write";
+        return false;
+    }
+    return true;
+}
+
+/*! \brief levelFile::addTo
+ *  clears the simulation and adds the level to it: mj and the good guys, the enemies, the blocks, the doors.
+ *  Without npcs the good guys and enemies are left out. Which way each npc starts walking is drawn from random
+ *  just like engine::LoadMap does, so a replay sees the same npcs as the game
+ */
+void levelFile::addTo(simulation &sim, bool npcs, gameRandom &random) const{
+    sim.clear(width, height);
+    sim.reserve((int)entries.size());
+    sim.setLives(lives);
+
+    const LevelKeyword order[4][2] = { { LEVEL_MJ, LEVEL_GOOD }, { LEVEL_ENEMY, LEVEL_ENEMY }, { LEVEL_BLOCK, LEVEL_MBLOCK },
+                                       { LEVEL_DOOR, LEVEL_DOOR } };
+    for(int pass = 0; pass < 4; pass++){
+        for(unsigned int i = 0; i < entries.size(); i++){
+            const levelEntry &e = entries[i];
+            if(e.keyword != order[pass][0] && e.keyword != order[pass][1])
+                continue;
+
+            int movement = 0;
+            if(e.keyword == LEVEL_GOOD || e.keyword == LEVEL_ENEMY)
+                movement = random.below(2);
+            if(e.keyword == LEVEL_MJ)
+                sim.addEntity(KIND_MJ, e.x, e.y);
+            else if(e.keyword == LEVEL_GOOD && npcs)
+                sim.addEntity(KIND_GOOD, e.x, e.y, movement, e.hasObj);
+            else if(e.keyword == LEVEL_ENEMY && npcs)
+                sim.addEntity(KIND_ENEMY, e.x, e.y, movement);
+            else if(e.keyword == LEVEL_BLOCK)
+                sim.addEntity(KIND_BLOCK, e.x, e.y);
+            else if(e.keyword == LEVEL_MBLOCK)
+                sim.addEntity(KIND_MBLOCK, e.x, e.y);
+            else if(e.keyword == LEVEL_DOOR)
+                sim.addEntity(KIND_DOOR, e.x, e.y);
+        }
+    }
+}
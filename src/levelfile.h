@@ -0,0 +1,42 @@
+#ifndef LEVELFILE_H
+#define LEVELFILE_H
+
+#include <string>
+#include <vector>
+#include "levelscanner.h"
+
+class simulation;
+class gameRandom;
+
+/* one line of a level file: type, picture, x, y and for GOOD the item it holds */
+struct levelEntry{
+    LevelKeyword keyword;  //type looked up once when read, what the game compares
+    std::string type;
+    std::string sprite;
+    int x;
+    int y;
+    std::string goodObj;
+    bool hasObj;
+};
+
+/* a level file read without Qt, for the tools that only need the core */
+struct levelFile{
+    int width;
+    int height;
+    int lives;
+    //empty when the level has no NEXT or CURRENT, the game then keeps the one it had
+    std::string next;
+    std::string current;
+    std::vector<levelEntry> entries;
+    //lines read() left out, with the file and line they were on
+    std::vector<std::string> warnings;
+
+    levelFile();
+    //the compiled level when there is a usable one, the text otherwise
+    bool read(const std::string &fileName, std::string &error);
+    bool readText(const std::string &fileName, std::string &error);
+    bool write(const std::string &fileName, std::string &error) const;
+    void addTo(simulation &sim, bool npcs, gameRandom &random) const;
+};
+
+#endif // LEVELFILE_H
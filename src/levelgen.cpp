@@ -0,0 +1,200 @@
+/*! \abstract levelGen
+ *         Writes big levels for testing how the parser, the engine and the tools cope with size. A level is floors every
+ *         floorGap rows with gaps in them, staircases that lead up through a hole in the floor above, and mj, the doors,
+ *         the movable blocks and the npcs standing on the floors. The same options and seed always give the same files.
+ */
+
+#include "levelgen.h"
+#include "gamerandom.h"
+#include "levelscanner.h"
+#include <fstream>
+
+//what is in a cell of the generated level
+enum GenCell{
+    GEN_EMPTY,
+    GEN_FLOOR,
+    GEN_STAIR,
+    GEN_HOLE,     //kept open so mj can climb through
+    GEN_TAKEN     //something stands here
+};
+
+//sprites the bundled levels use, the generated ones go round them
+static const char *goodSprites[3] = { "pauladeen", "columbian_man", "mexican_man" };
+static const char *goodItems[3] = { "sprites/butter", "sprites/chocolate", "sprites/vanilla" };
+static const char *enemySprites[4] = { "enemy1", "enemy2", "enemy3", "enemy4" };
+
+levelGenOptions::levelGenOptions(){
+    width = 300;
+    height = 200;
+    floorGap = 4;
+    floorDensity = 90;
+    stairs = 4;
+    mblocks = 100;
+    goods = 50;
+    enemies = 50;
+    doors = 1;
+    chain = 1;
+    seed = 1;
+}
+
+/* one level being made, cells are kept for y 0 .. height + 1 */
+struct genLevel{
+    int width;
+    int height;
+    std::vector<unsigned char> cells;
+
+    unsigned char &at(int x, int y) { return cells[(size_t)y*width + x]; }
+    bool solid(int x, int y) { return at(x, y) == GEN_FLOOR || at(x, y) == GEN_STAIR; }
+};
+
+/*! \brief standingSpot
+ *  a random free cell with a block under it, false if none turned up after a good number of tries
+ */
+static bool standingSpot(genLevel &level, gameRandom &random, int floorGap, int &x, int &y){
+    int floors = (level.height - 2)/floorGap + 1;
+    for(int tries = 0; tries < 1000; tries++){
+        x = random.below(level.width);
+        y = 1 + random.below(floors)*floorGap + 1;
+        if(y <= level.height && level.solid(x, y - 1) && level.at(x, y) == GEN_EMPTY)
+            return true;
+    }
+    return false;
+}
+
+/*! \brief stairRoom
+ *  false if a staircase at x0 would run into one that is already there, or fill the hole one below climbs through
+ */
+static bool stairRoom(genLevel &level, int x0, int lower, int gap){
+    for(int x = x0 - 1; x <= x0 + gap - 1; x++){
+        for(int y = lower; y <= lower + gap; y++){
+            if(level.at(x, y) == GEN_STAIR || level.at(x, y) == GEN_HOLE)
+                return false;
+        }
+    }
+    return true;
+}
+
+static bool writeLevel(const levelGenOptions &options, gameRandom &random, const std::string &name,
+                       const std::string &next, std::string &error){
+    genLevel level;
+    level.width = options.width;
+    level.height = options.height;
+    level.cells.assign((size_t)options.width*(options.height + 2), GEN_EMPTY);
+    int gap = options.floorGap;
+
+    //floors at y = 1, 1 + gap, ... and never in the top row, something has to fit on them
+    for(int y = 1; y < options.height; y += gap){
+        for(int x = 0; x < options.width; x++){
+            if(y == 1 || random.below(100) < options.floorDensity)
+                level.at(x, y) = GEN_FLOOR;
+        }
+    }
+
+    //a staircase climbs one block a column from the floor at lower to the one at y, mj steps off its top
+    //through a hole onto the floor above. The cells it needs are made whole or open, mj's cell is kept clear of them
+    for(int y = 1 + gap; y < options.height && options.width > gap + 4; y += gap){
+        int lower = y - gap;
+        for(int s = 0; s < options.stairs; s++){
+            int x0 = 3 + random.below(options.width - gap - 3);
+            if(!stairRoom(level, x0, lower, gap))
+                continue;
+            for(int x = x0 - 1; x <= x0 + gap - 1; x++)
+                level.at(x, lower) = GEN_FLOOR;
+            for(int k = 0; k <= gap - 2; k++){
+                level.at(x0 + k, lower + 1 + k) = GEN_STAIR;
+                for(int above = lower + 2 + k; above < y; above++)
+                    level.at(x0 + k, above) = GEN_HOLE;
+            }
+            level.at(x0 + gap - 2, y) = GEN_HOLE;
+            level.at(x0 + gap - 1, y) = GEN_FLOOR;
+        }
+    }
+
+    std::ofstream out(name.c_str());
+    if(!out){
+        error = name + ": can not write";
+        return false;
+    }
+    out << "#made by levelgen, seed " << options.seed << "\n";
+    out << "LIVES, 3\n";
+    out << "NEXT, " << next << "\n";
+    out << "CURRENT, " << name << "\n";
+    out << "SIZE, " << options.width << ", " << options.height << "\n";
+    out << "BACKGROUND, starrynight\n";
+
+    //mj bottom left with the first door behind her like the bundled levels, and the first movable block in front of her
+    level.at(1, 2) = GEN_TAKEN;
+    level.at(0, 2) = GEN_TAKEN;
+    out << "MJ, MJ_left, 1, 2\n";
+    out << "DOOR, door, 0, 2\n";
+    if(options.mblocks > 0){
+        level.at(2, 2) = GEN_TAKEN;
+        out << "MBLOCK, move_wood, 2, 2\n";
+    }
+
+    int x, y;
+    for(int d = 1; d < options.doors && standingSpot(level, random, gap, x, y); d++){
+        level.at(x, y) = GEN_TAKEN;
+        out << "DOOR, door, " << x << ", " << y << "\n";
+    }
+    for(int g = 0; g < options.goods && standingSpot(level, random, gap, x, y); g++){
+        level.at(x, y) = GEN_TAKEN;
+        out << "GOOD, " << goodSprites[g % 3] << ", " << x << ", " << y << ", " << goodItems[g % 3] << ", 1\n";
+    }
+    for(int e = 0; e < options.enemies && standingSpot(level, random, gap, x, y); e++){
+        level.at(x, y) = GEN_TAKEN;
+        out << "ENEMY, " << enemySprites[e % 4] << ", " << x << ", " << y << "\n";
+    }
+    for(int m = 1; m < options.mblocks && standingSpot(level, random, gap, x, y); m++){
+        level.at(x, y) = GEN_TAKEN;
+        out << "MBLOCK, move_wood, " << x << ", " << y << "\n";
+    }
+
+    for(y = 1; y <= options.height; y++){
+        for(x = 0; x < options.width; x++){
+            if(level.at(x, y) == GEN_FLOOR)
+                out << "BLOCK, woodfloor, " << x << ", " << y << "\n";
+            else if(level.at(x, y) == GEN_STAIR)
+                out << "BLOCK, stairwood, " << x << ", " << y << "\n";
+        }
+    }
+
+    if(!out){
+        error = name + ": can not write";
+        return false;
+    }
+    return true;
+}
+
+/*! \brief generateLevels
+ *  writes the chain of levels, written gets their names
+ */
+bool generateLevels(const levelGenOptions &options, const std::string &baseName, std::vector<std::string> &written,
+                    std::string &error){
+    if(options.width < 4 || options.height < 4 || options.floorGap < 2 || options.chain < 1){
+        error = "levels need to be at least 4x4, floors 2 apart, and there has to be at least one";
+        return false;
+    }
+    if(!levelScanner::sizeFits(options.width, options.height)){
+        error = "levels can be at most " + std::to_string(LEVEL_MAX_SIDE) + " on a side and " +
+                std::to_string(LEVEL_MAX_CELLS) + " cells";
+        return false;
+    }
+
+    std::vector<std::string> names;
+    for(int l = 0; l < options.chain; l++){
+        if(options.chain == 1)
+            names.push_back(baseName);
+        else
+            names.push_back(baseName + "-" + std::to_string(l + 1));
+    }
+
+    gameRandom random(options.seed);
+    written.clear();
+    for(int l = 0; l < options.chain; l++){
+        if(!writeLevel(options, random, names[l], names[(l + 1) % options.chain], error))
+            return false;
+        written.push_back(names[l]);
+    }
+    return true;
+}
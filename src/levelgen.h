@@ -0,0 +1,31 @@
+#ifndef LEVELGEN_H
+#define LEVELGEN_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/* what levelGen writes. Counts are per level, whatever there is no room for is left out. The levels load and play
+   but nothing makes sure they can be finished, a gap in a floor is a wall to mj and can shut her in */
+struct levelGenOptions{
+    int width;
+    int height;
+    int floorGap;       //rows from one floor to the next, at least 2
+    int floorDensity;   //percent of a floor's cells that have a block, the bottom floor is always whole
+    int stairs;         //staircases up to each floor
+    int mblocks;
+    int goods;
+    int enemies;
+    int doors;
+    int chain;          //levels written, each one's NEXT is the one after, the last goes back to the first
+    uint32_t seed;
+
+    levelGenOptions();
+};
+
+/* writes levels in the usual TYPE, sprite, x, y format: baseName when chain is 1, baseName-1 .. baseName-n otherwise.
+   The names go into NEXT and CURRENT as given, so they should be relative to where the game runs */
+bool generateLevels(const levelGenOptions &options, const std::string &baseName, std::vector<std::string> &written,
+                    std::string &error);
+
+#endif // LEVELGEN_H
@@ -0,0 +1,118 @@
+/*! \abstract levelPrefetch
+ *         As soon as a level is up the engine starts reading the one its NEXT line names here, on a thread of its
+ *         own: the parser fills a set of lists and every sprite the level uses that the engine hasn't decoded yet is
+ *         decoded into a QImage. Going through the door then only swaps the lists in and turns the images into
+ *         pixmaps, the parse and the png decoding are already done.
+ */
+
+#include "levelprefetch.h"
+#include "assets.h"
+#include "spritecache.h"
+#include "trace.h"
+
+levelPrefetch::levelPrefetch(){
+    level = NULL;
+    pending = false;
+    busy = false;
+    quit = false;
+    worker = std::thread(&levelPrefetch::work, this);
+}
+
+levelPrefetch::~levelPrefetch(){
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_one();
+    worker.join();
+    delete level;
+}
+
+/*! \brief levelPrefetch::start
+ *  drops what was prepared before, a level nobody took is not needed any more. If the thread is still on it,
+ *  this waits for it to finish first
+ */
+void levelPrefetch::start(const QString &fileName, const QSet<QString> &decoded){
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        finished.wait(guard, [this]{ return !busy; });
+        delete level;
+        level = new preparedLevel();
+        level->fileName = fileName;
+        level->result = -1;
+        this->decoded = decoded;
+        pending = true;
+    }
+    wake.notify_one();
+}
+
+bool levelPrefetch::has(const QString &fileName){
+    std::unique_lock<std::mutex> guard(lock);
+    return level != NULL && level->fileName == fileName;
+}
+
+bool levelPrefetch::ready(const QString &fileName){
+    std::unique_lock<std::mutex> guard(lock);
+    return level != NULL && level->fileName == fileName && !pending && !busy;
+}
+
+preparedLevel *levelPrefetch::take(const QString &fileName){
+    std::unique_lock<std::mutex> guard(lock);
+    if(level == NULL || level->fileName != fileName)
+        return NULL;
+    finished.wait(guard, [this]{ return !pending && !busy; });
+    preparedLevel *taken = level;
+    level = NULL;
+    return taken;
+}
+
+void levelPrefetch::work(){
+    traceLog::nameThread("prefetch");
+    std::unique_lock<std::mutex> guard(lock);
+    while(true){
+        wake.wait(guard, [this]{ return pending || quit; });
+        if(quit)
+            return;
+        pending = false;
+        busy = true;
+        preparedLevel *working = level;
+        QSet<QString> skip = decoded;
+        guard.unlock();
+
+        prepare(working, skip);
+
+        guard.lock();
+        busy = false;
+        finished.notify_all();
+    }
+}
+
+/*! \brief levelPrefetch::prepare
+ *  runs on the prefetch thread. Only the level's own parser and lists and the asset store are touched, the gui
+ *  thread doesn't get at the level until busy is cleared
+ */
+void levelPrefetch::prepare(preparedLevel *level, QSet<QString> decoded){
+    TRACE_SCOPE("prefetch level");
+    //names the file doesn't set stay empty, the engine keeps its own for those
+    level->parsley.curLevel.clear();
+    level->parsley.nextLevel.clear();
+    level->result = level->parsley.readFile(NULL, &level->good, &level->enemies, &level->blocks, &level->doors,
+                                            &level->other, level->fileName);
+
+    objStructure *lists[5] = { &level->good, &level->enemies, &level->blocks, &level->doors, &level->other };
+    for(int l = 0; l < 5; l++){
+        for(int i = 0; i < lists[l]->getCount(); i++){
+            const QString *names[2] = { &lists[l]->location.at(i), &lists[l]->goodObj.at(i) };
+            for(int n = 0; n < 2; n++){
+                if(names[n]->isEmpty())
+                    continue;
+                QString name = spriteCache::canonicalName(*names[n]);
+                if(decoded.contains(name))
+                    continue;
+                decoded.insert(name);
+                TRACE_SCOPE("decode sprite");
+                level->images.insert(name, assets().image("sprites/" + name + ".png"));
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef LEVELPREFETCH_H
+#define LEVELPREFETCH_H
+
+#include <QtCore>
+#include <QtGui>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "objStructure.h"
+#include "parser.h"
+
+/* a level read by the parser and the pictures it needs decoded, everything the engine would otherwise do on the
+   gui thread before it can put the level in the scene. The lists have no sprite ids yet, QPixmaps can only be made
+   on the gui thread so the pictures are QImages */
+struct preparedLevel{
+    QString fileName;
+    int result;
+    parser parsley;
+    objStructure good;
+    objStructure enemies;
+    objStructure blocks;
+    objStructure doors;
+    objStructure other;
+    QHash<QString, QImage> images;   //by canonical sprite name
+};
+
+/* prepares one level at a time on a thread it keeps for that. start() hands the work off and returns, take() gives
+   the level once the thread is done with it, waiting if it isn't yet */
+class levelPrefetch
+{
+public:
+    levelPrefetch();
+    ~levelPrefetch();
+
+    //decoded are the sprites the engine has already, they aren't decoded again
+    void start(const QString &fileName, const QSet<QString> &decoded);
+    //fileName was started and not taken yet
+    bool has(const QString &fileName);
+    //true once the level started for fileName is prepared, take() won't wait then
+    bool ready(const QString &fileName);
+    //the prepared level, the caller owns it. NULL if nothing was started for fileName
+    preparedLevel *take(const QString &fileName);
+
+private:
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    preparedLevel *level;
+    QSet<QString> decoded;
+    bool pending;
+    bool busy;
+    bool quit;
+
+    void work();
+    static void prepare(preparedLevel *level, QSet<QString> decoded);
+};
+
+#endif // LEVELPREFETCH_H
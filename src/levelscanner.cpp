@@ -0,0 +1,174 @@
+/*! \abstract levelScanner
+ *         Reads levels for the parser and for levelFile. The whole file is in memory, mapped or read in one go, and the
+ *         scanner walks it with memchr: a line is cut into fields that point into the text, the keyword is looked up with
+ *         a perfect hash and the numbers are read straight from the bytes. Nothing is allocated unless a line is wrong.
+ */
+
+#include "levelscanner.h"
+#include <cstring>
+
+//a GOOD line has the most, anything past them is ignored
+#define LEVEL_MAX_FIELDS ( 6 )
+
+static const char *keywordNames[LEVEL_OTHER] = {
+    "MJ", "GOOD", "ENEMY", "BLOCK", "MBLOCK", "DOOR", "NEXT", "CURRENT", "LIVES", "SIZE", "BACKGROUND"
+};
+
+//(first char + last char + 2*length) & 31 is different for every keyword, this maps it back
+static const signed char keywordSlots[32] = {
+    LEVEL_SIZE, -1, -1, -1, LEVEL_MBLOCK, LEVEL_CURRENT, -1, -1,
+    LEVEL_ENEMY, LEVEL_LIVES, LEVEL_NEXT, -1, -1, -1, -1, -1,
+    -1, -1, -1, LEVEL_GOOD, -1, -1, -1, LEVEL_BLOCK,
+    -1, -1, LEVEL_BACKGROUND, LEVEL_MJ, -1, -1, LEVEL_DOOR, -1
+};
+
+bool levelField::equals(const levelField &other) const{
+    return length == other.length && memcmp(text, other.text, length) == 0;
+}
+
+levelScanner::levelScanner(const char *data, size_t size){
+    at = data;
+    end = data + size;
+    lineNumber = 0;
+}
+
+/*! \brief levelScanner::keyword
+ *  one hash, one table lookup and one memcmp
+ */
+LevelKeyword levelScanner::keyword(const char *text, int length){
+    if(length < 2)
+        return LEVEL_OTHER;
+    int slot = ((unsigned char)text[0] + (unsigned char)text[length - 1] + (length << 1)) & 31;
+    int k = keywordSlots[slot];
+    if(k < 0 || (int)strlen(keywordNames[k]) != length || memcmp(keywordNames[k], text, length) != 0)
+        return LEVEL_OTHER;
+    return (LevelKeyword)k;
+}
+
+//"" for LEVEL_OTHER, whose name is whatever the line said
+const char *levelScanner::keywordName(LevelKeyword keyword){
+    return keyword < LEVEL_OTHER ? keywordNames[keyword] : "";
+}
+
+/*! \brief levelScanner::toInt
+ *  the whole field has to be the number, a sign is allowed
+ */
+bool levelScanner::toInt(const levelField &field, int &value){
+    const char *c = field.text;
+    const char *last = field.text + field.length;
+    bool negative = false;
+    if(c < last && (*c == '-' || *c == '+')){
+        negative = *c == '-';
+        c++;
+    }
+    if(c == last)
+        return false;
+
+    long long n = 0;
+    for(; c < last; c++){
+        if(*c < '0' || *c > '9' || n > 0x7FFFFFFF)
+            return false;
+        n = n*10 + (*c - '0');
+    }
+    if(n > 0x7FFFFFFF)
+        return false;
+    value = (int)(negative ? -n : n);
+    return true;
+}
+
+static levelField trimmed(const char *begin, const char *finish){
+    while(begin < finish && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+        begin++;
+    while(finish > begin && (finish[-1] == ' ' || finish[-1] == '\t' || finish[-1] == '\r'))
+        finish--;
+    levelField field;
+    field.text = begin;
+    field.length = (int)(finish - begin);
+    return field;
+}
+
+bool levelScanner::sizeFits(long long width, long long height){
+    return width >= 1 && height >= 1 && width <= LEVEL_MAX_SIDE && height <= LEVEL_MAX_SIDE &&
+           width*height <= LEVEL_MAX_CELLS;
+}
+
+bool levelScanner::fail(const levelLine &line, const std::string &why){
+    errors.push_back("line " + std::to_string(line.number) + ": " + line.type.str() + " " + why);
+    return false;
+}
+
+/*! \brief levelScanner::next
+ *  the next line that made sense, false once the text is used up
+ */
+bool levelScanner::next(levelLine &line){
+    while(at < end){
+        const char *start = at;
+        const char *lineEnd = (const char*)memchr(start, '\n', end - start);
+        if(lineEnd == NULL)
+            lineEnd = end;
+        at = lineEnd < end ? lineEnd + 1 : end;
+        lineNumber++;
+
+        //a comment can start anywhere on the line and takes all of it
+        if(memchr(start, '#', lineEnd - start) != NULL)
+            continue;
+
+        levelField fields[LEVEL_MAX_FIELDS];
+        int count = 0;
+        for(const char *f = start; ; ){
+            const char *comma = (const char*)memchr(f, ',', lineEnd - f);
+            if(count < LEVEL_MAX_FIELDS)
+                fields[count++] = trimmed(f, comma ? comma : lineEnd);
+            if(comma == NULL)
+                break;
+            f = comma + 1;
+        }
+        if(count == 1 && fields[0].length == 0)
+            continue;
+
+        line.number = lineNumber;
+        line.type = fields[0];
+        line.keyword = keyword(fields[0].text, fields[0].length);
+        line.text = count > 1 ? fields[1] : fields[0];
+        line.x = -1;
+        line.y = -1;
+        line.item = fields[0];
+        line.item.length = 0;
+        line.hasItem = -1;
+
+        bool ok = true;
+        if(line.keyword == LEVEL_NEXT || line.keyword == LEVEL_CURRENT || line.keyword == LEVEL_BACKGROUND){
+            if(count < 2 || fields[1].length == 0)
+                ok = fail(line, "needs a name");
+        }
+        else if(line.keyword == LEVEL_LIVES){
+            if(count < 2 || !toInt(fields[1], line.x))
+                ok = fail(line, "needs a number");
+            else if(line.x < 1 || line.x > LEVEL_MAX_LIVES)
+                ok = fail(line, "has to be 1 to " + std::to_string(LEVEL_MAX_LIVES));
+        }
+        else if(line.keyword == LEVEL_SIZE){
+            if(count < 3 || !toInt(fields[1], line.x) || !toInt(fields[2], line.y) || line.x < 1 || line.y < 1)
+                ok = fail(line, "needs a width and a height");
+            else if(!sizeFits(line.x, line.y))
+                ok = fail(line, "is bigger than a level can be");
+        }
+        //everything else has a sprite and a position, GOOD also the item it holds
+        else if(count < 4 || fields[1].length == 0)
+            ok = fail(line, "needs a sprite, x and y");
+        else if(!toInt(fields[2], line.x) || !toInt(fields[3], line.y))
+            ok = fail(line, "needs numbers for x and y");
+        else if(line.keyword == LEVEL_GOOD){
+            if(count < 5 || fields[4].length == 0)
+                ok = fail(line, "needs an item after x and y");
+            else{
+                line.item = fields[4];
+                if(count > 5 && !toInt(fields[5], line.hasItem))
+                    line.hasItem = -1;
+            }
+        }
+        if(ok)
+            return true;
+    }
+    return false;
+}
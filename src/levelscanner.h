@@ -0,0 +1,76 @@
+#ifndef LEVELSCANNER_H
+#define LEVELSCANNER_H
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+//the biggest level SIZE can ask for: no side longer than LEVEL_MAX_SIDE and no more than LEVEL_MAX_CELLS in all,
+//the simulation keeps a few arrays of that many cells
+#define LEVEL_MAX_SIDE ( 16384 )
+#define LEVEL_MAX_CELLS ( 4096*4096 )
+//the game has a heart for each life and room for this many
+#define LEVEL_MAX_LIVES ( 3 )
+
+/* the word a line of a level starts with */
+enum LevelKeyword{
+    LEVEL_MJ,
+    LEVEL_GOOD,
+    LEVEL_ENEMY,
+    LEVEL_BLOCK,
+    LEVEL_MBLOCK,
+    LEVEL_DOOR,
+    LEVEL_NEXT,
+    LEVEL_CURRENT,
+    LEVEL_LIVES,
+    LEVEL_SIZE,
+    LEVEL_BACKGROUND,
+    LEVEL_OTHER       //anything else is scenery with a position, like the parser always did
+};
+
+/* a piece of the text being scanned, nothing is copied */
+struct levelField{
+    const char *text;
+    int length;
+
+    std::string str() const { return std::string(text, length); }
+    bool equals(const levelField &other) const;
+};
+
+/* one line that made sense. What the numbers are depends on the keyword */
+struct levelLine{
+    int number;            //in the file, from 1
+    LevelKeyword keyword;
+    levelField type;       //the keyword as written
+    levelField text;       //the sprite, the path for NEXT and CURRENT
+    int x;                 //x, the lives for LIVES, the width for SIZE, -1 for BACKGROUND
+    int y;                 //y, the height for SIZE, -1 for BACKGROUND
+    levelField item;       //GOOD: the item it holds
+    int hasItem;           //GOOD: the sixth field, -1 if there is none
+};
+
+/* splits a level held in memory into lines without allocating. Comments and blank lines are skipped, so are lines
+   that don't have what their keyword needs, with a note in errors saying which line and why */
+class levelScanner
+{
+public:
+    levelScanner(const char *data, size_t size);
+
+    bool next(levelLine &line);
+    std::vector<std::string> errors;
+
+    static LevelKeyword keyword(const char *text, int length);
+    static const char *keywordName(LevelKeyword keyword);
+    static bool toInt(const levelField &field, int &value);
+    //width by height is a size SIZE may give
+    static bool sizeFits(long long width, long long height);
+
+private:
+    const char *at;
+    const char *end;
+    int lineNumber;
+
+    bool fail(const levelLine &line, const std::string &why);
+};
+
+#endif // LEVELSCANNER_H
@@ -0,0 +1,68 @@
+/*! \abstract levelsolver
+ *         Runs the level solver over level files (levelsolver ../levels/name ...) and prints for each one whether it can be beaten,
+ *         the fewest key presses that do it, how many states were searched and a difficulty score. -t sets the threads,
+ *         -m the memory for the search in megabytes and -q leaves out the key presses.
+ */
+
+#include "levelfile.h"
+#include "solver.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+int main(int argc, char *argv[]){
+    int threads = std::thread::hardware_concurrency();
+    long long megabytes = 1024;
+    bool quiet = false;
+    std::vector<std::string> files;
+    for(int a = 1; a < argc; a++){
+        if(strcmp(argv[a], "-t") == 0 && a + 1 < argc)
+            threads = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-m") == 0 && a + 1 < argc)
+            megabytes = atoll(argv[++a]);
+        else if(strcmp(argv[a], "-q") == 0)
+            quiet = true;
+        else
+            files.push_back(argv[a]);
+    }
+    if(files.empty()){
+        printf("usage: levelsolver [-t threads] [-m megabytes] [-q] levelfile...\n");
+        return 2;
+    }
+    if(threads < 1)
+        threads = 1;
+
+    int failed = 0;
+    printf("%-24s %-10s %6s %6s %5s %10s %8s %10s\n", "level", "result", "moves", "blocks", "risk", "states", "seconds",
+           "difficulty");
+    for(unsigned int f = 0; f < files.size(); f++){
+        levelFile level;
+        std::string error;
+        const char *name = strrchr(files[f].c_str(), '/') ? strrchr(files[f].c_str(), '/') + 1 : files[f].c_str();
+        if(!level.read(files[f], error)){
+            printf("%-24s %s\n", name, error.c_str());
+            failed++;
+            continue;
+        }
+        for(unsigned int w = 0; w < level.warnings.size(); w++)
+            printf("%s\n", level.warnings[w].c_str());
+
+        levelSolver solver(level, threads, megabytes*1024*1024);
+        solverResult result = solver.solve();
+        const char *status = result.status == SOLVER_SOLVED ? "solved" :
+                             result.status == SOLVER_UNSOLVABLE ? "unsolvable" : "unknown";
+        if(result.status == SOLVER_SOLVED)
+            printf("%-24s %-10s %6d %6d %5d %10lld %8.3f %10.1f\n", name, status, (int)result.inputs.size(),
+                   result.blockMoves, result.exposure, result.states, result.seconds, result.difficulty);
+        else{
+            printf("%-24s %-10s %6s %6s %5s %10lld %8.3f %10s\n", name, status, "-", "-", "-", result.states, result.seconds, "-");
+            failed++;
+        }
+        if(!result.note.empty())
+            printf("    %s\n", result.note.c_str());
+        if(!quiet && result.status == SOLVER_SOLVED)
+            printf("    %s\n", result.inputs.c_str());
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+#searches every level given on the command line for the shortest way through
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+include(core.pri)
+SOURCES += levelsolver.cpp
+TARGET = levelsolver
@@ -2,6 +2,18 @@
 
 int main(int argc, char *argv[]){
     QApplication app(argc, argv);
+
+    //baking_game -replay file plays a recorded session instead of showing the menu
+    if(argc > 2 && QString(argv[1]) == "-replay"){
+        gamewindow *replayWindow = new gamewindow(0, true, QString(), QString(argv[2]));
+        replayWindow->setWindowIcon(QIcon(assets().pixmap("sprites/MJ_left.png")));
+        replayWindow->setWindowTitle(QString("Mary Jane's Baking Quest - replay"));
+        replayWindow->setCentralWidget( replayWindow->GetGraphicsView() );
+        replayWindow->resize( replayWindow->centralWidget()->width(), replayWindow->centralWidget()->height() );
+        replayWindow->show();
+        return app.exec();
+    }
+
     start*  window = new start();
     window->show();
     return app.exec();
@@ -0,0 +1,480 @@
+/*! \abstract mjfuzz
+ *         Throws key sequences at the game rules, headless, to find crashes and broken states. One worker process per core
+ *         plays sequences against the levels given on the command line. A sequence that gets mj into a state no sequence
+ *         reached before is kept and later ones are made by changing kept ones, so the search spreads over the level instead
+ *         of pressing keys at random around the start. After every tick a few things that must always hold are checked.
+ *
+ *         The target is built with the address and undefined behaviour sanitizers. When a worker dies the sequence it was
+ *         playing is written out as a replay, and once the time is up each of those is cut down to the fewest keys that
+ *         still crash it. mjfuzz -check file plays one replay with the checks on, mjreplay plays it without.
+ *
+ *         mjfuzz [-j workers] [-t seconds] [-o dir] level...
+ *         mjfuzz -check replay
+ *         mjfuzz -minimize replay
+ */
+
+#include "headlessgame.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+#define FUZZ_MAX_KEYS ( 256 )
+#define FUZZ_CORPUS ( 4096 )
+//the bit map of states seen, per level
+#define FUZZ_COVERAGE_BITS ( 20 )
+
+//the sanitizers call this just before they end the process. It is only there in a build with them
+extern "C" void __sanitizer_set_death_callback(void (*callback)(void)) __attribute__((weak));
+
+/* what a worker has done so far, in memory shared with the parent */
+struct fuzzCounters{
+    volatile unsigned long long runs;
+    volatile unsigned long long ticks;
+    volatile unsigned long long corpus;
+};
+
+/* a key in a sequence, delta is the ticks since the key before */
+struct fuzzKey{
+    int delta;
+    int key;
+};
+
+struct fuzzEntry{
+    uint32_t seed;
+    std::vector<fuzzKey> keys;
+};
+
+//the sequence playing right now, written out if the process dies
+static const replay *playing = NULL;
+static char crashFile[512];
+
+static void saveCrash(){
+    if(playing == NULL)
+        return;
+    std::string error;
+    playing->save(crashFile, error);
+    playing = NULL;
+}
+
+static void crashSignal(int sig){
+    saveCrash();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+static void catchCrashes(){
+    if(__sanitizer_set_death_callback)
+        __sanitizer_set_death_callback(saveCrash);
+    else{
+        signal(SIGSEGV, crashSignal);
+        signal(SIGBUS, crashSignal);
+        signal(SIGFPE, crashSignal);
+        signal(SIGILL, crashSignal);
+    }
+    //failed checks abort, the sanitizers leave that signal alone
+    signal(SIGABRT, crashSignal);
+}
+
+/*! \brief check
+ *  things that have to be true after every tick, a broken one ends the process like a crash would
+ */
+static void check(const headlessGame &game){
+    const simulation &sim = game.state();
+    const char *broken = NULL;
+    if(sim.mjId() != -1){
+        Entity m = sim.entity(sim.mjId());
+        if(m.x < 0 || m.x >= sim.width() || m.y < 1 || m.y > sim.height() + 1)
+            broken = "mj left the field";
+        else if(sim.carriedBlock() != -1){
+            Entity b = sim.entity(sim.carriedBlock());
+            if(b.x != m.x || b.y != m.y + 1)
+                broken = "the block mj carries is not on her head";
+        }
+    }
+    if(sim.lives() < 0)
+        broken = "lives went below 0";
+    else if(sim.itemCount() < 0)
+        broken = "more items taken than there were";
+
+    if(broken != NULL){
+        fprintf(stderr, "check failed on tick %llu of %s: %s\n", (unsigned long long)game.ticks(), game.levelName().c_str(), broken);
+        abort();
+    }
+}
+
+//which state mj is in, as a bit in the coverage map
+static uint32_t feature(const headlessGame &game){
+    const simulation &sim = game.state();
+    uint64_t f = (uint64_t)game.loads() << 56 | (uint64_t)sim.lives() << 48 | (uint64_t)sim.itemCount() << 40 |
+                 (uint64_t)(sim.carriedBlock() != -1) << 39;
+    if(sim.mjId() != -1){
+        Entity m = sim.entity(sim.mjId());
+        f |= (uint64_t)(m.y & 0xFFFF) << 20 | (uint64_t)(m.x & 0xFFFFF);
+    }
+    f *= 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(f >> (64 - FUZZ_COVERAGE_BITS));
+}
+
+static int randomKey(gameRandom &random){
+    int roll = random.below(100);
+    if(roll < 32)
+        return REPLAY_LEFT;
+    if(roll < 64)
+        return REPLAY_RIGHT;
+    if(roll < 94)
+        return REPLAY_SPACE;
+    if(roll < 99)
+        return REPLAY_RESTART;
+    return REPLAY_SAVE;
+}
+
+static fuzzKey randomStep(gameRandom &random){
+    fuzzKey k;
+    //mostly quicker than the npcs walk, sometimes a long wait
+    k.delta = random.below(8) == 0 ? random.below(NPC_TICKS*8) : random.below(NPC_TICKS);
+    k.key = randomKey(random);
+    return k;
+}
+
+/*! \brief mutate
+ *  a few random changes to a kept sequence, or a splice with another one
+ */
+static void mutate(std::vector<fuzzKey> &keys, const std::vector<fuzzEntry> &corpus, gameRandom &random){
+    int changes = 1 + random.below(4);
+    for(int c = 0; c < changes; c++){
+        int size = (int)keys.size();
+        int at = size > 0 ? random.below(size) : 0;
+        switch(random.below(6)){
+        case 0:
+            if(size > 0)
+                keys[at].key = randomKey(random);
+            break;
+        case 1:
+            if(size > 0)
+                keys[at].delta = randomStep(random).delta;
+            break;
+        case 2:
+            keys.insert(keys.begin() + at, randomStep(random));
+            break;
+        case 3:
+            if(size > 0)
+                keys.erase(keys.begin() + at, keys.begin() + at + 1 + random.below(size - at));
+            break;
+        case 4:
+            if(!corpus.empty()){
+                const std::vector<fuzzKey> &other = corpus[random.below((int)corpus.size())].keys;
+                int from = other.empty() ? 0 : random.below((int)other.size());
+                keys.resize(at);
+                keys.insert(keys.end(), other.begin() + from, other.end());
+            }
+            break;
+        default:
+            for(int n = 1 + random.below(16); n > 0; n--)
+                keys.push_back(randomStep(random));
+            break;
+        }
+    }
+    if(keys.size() > FUZZ_MAX_KEYS)
+        keys.resize(FUZZ_MAX_KEYS);
+}
+
+static void toReplay(const fuzzEntry &entry, const std::string &level, uint64_t levelHash, replay &session){
+    session.start(entry.seed, level, levelHash);
+    uint64_t tick = 0;
+    for(unsigned int k = 0; k < entry.keys.size(); k++){
+        tick += entry.keys[k].delta;
+        session.record(tick, entry.keys[k].key);
+    }
+    session.finish(tick + NPC_TICKS*2);
+}
+
+/*! \brief fuzz
+ *  one worker, plays sequences until the time is up
+ */
+static void fuzz(int worker, uint32_t seed, const std::vector<std::string> &levels, double seconds, fuzzCounters *counters){
+    gameRandom random(seed);
+    headlessGame game(0);
+    std::vector<uint64_t> hashes(levels.size());
+    std::vector<std::vector<fuzzEntry> > corpus(levels.size());
+    std::vector<std::vector<uint64_t> > coverage(levels.size(), std::vector<uint64_t>((1 << FUZZ_COVERAGE_BITS)/64, 0));
+    for(unsigned int l = 0; l < levels.size(); l++){
+        if(!replay::hashFile(levels[l], hashes[l])){
+            fprintf(stderr, "%s: can not open\n", levels[l].c_str());
+            _exit(2);
+        }
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    replay session;
+    fuzzEntry entry;
+    for(unsigned long long run = 0; ; run++){
+        if(run % 64 == 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= seconds)
+            break;
+
+        int l = (int)(run % levels.size());
+        std::vector<fuzzEntry> &kept = corpus[l];
+        if(!kept.empty() && random.below(8) != 0){
+            entry = kept[random.below((int)kept.size())];
+            if(random.below(16) == 0)
+                entry.seed = random.next();
+            mutate(entry.keys, kept, random);
+        }
+        else{
+            entry.seed = random.next();
+            entry.keys.clear();
+            for(int n = 1 + random.below(64); n > 0; n--)
+                entry.keys.push_back(randomStep(random));
+        }
+        toReplay(entry, levels[l], hashes[l], session);
+
+        std::string error;
+        playing = &session;
+        if(!game.begin(session, error)){
+            playing = NULL;
+            fprintf(stderr, "worker %d: %s\n", worker, error.c_str());
+            _exit(2);
+        }
+        bool novel = false;
+        std::vector<uint64_t> &seen = coverage[l];
+        do{
+            check(game);
+            uint32_t bit = feature(game);
+            if(!(seen[bit/64] & (1ULL << (bit%64)))){
+                seen[bit/64] |= 1ULL << (bit%64);
+                novel = true;
+            }
+        } while(game.advance());
+        playing = NULL;
+
+        if(novel){
+            if(kept.size() < FUZZ_CORPUS)
+                kept.push_back(entry);
+            else
+                kept[random.below(FUZZ_CORPUS)] = entry;
+            counters->corpus++;
+        }
+        counters->runs++;
+        counters->ticks += game.ticks();
+    }
+}
+
+/*! \brief crashes
+ *  plays a replay with the checks on in a child process, true if the child did not come back cleanly
+ */
+static bool crashes(const replay &session){
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid == 0){
+        //the sanitizer reports would bury the output, only the answer matters here
+        if(freopen("/dev/null", "w", stderr) == NULL)
+            _exit(0);
+        headlessGame game(0);
+        std::string error;
+        if(!game.begin(session, error))
+            _exit(0);
+        do
+            check(game);
+        while(game.advance());
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFSIGNALED(status) || WEXITSTATUS(status) != 0;
+}
+
+/*! \brief minimize
+ *  takes keys out of a crashing replay as long as it still crashes, bigger runs of keys first, then ends it as early as it can
+ */
+static int minimize(const std::string &fileName){
+    replay session;
+    std::string error;
+    if(!session.load(fileName, error)){
+        printf("%s\n", error.c_str());
+        return 2;
+    }
+    if(!crashes(session)){
+        printf("%s: does not crash when played again\n", fileName.c_str());
+        return 1;
+    }
+
+    size_t before = session.inputs.size();
+    for(size_t chunk = session.inputs.size()/2; chunk >= 1; chunk /= 2){
+        for(size_t at = 0; at < session.inputs.size(); ){
+            replay smaller = session;
+            size_t end = at + chunk < smaller.inputs.size() ? at + chunk : smaller.inputs.size();
+            smaller.inputs.erase(smaller.inputs.begin() + at, smaller.inputs.begin() + end);
+            if(crashes(smaller))
+                session = smaller;
+            else
+                at += chunk;
+        }
+    }
+
+    //the earliest end tick that still crashes, not before the last key
+    uint64_t low = session.inputs.empty() ? 0 : session.inputs.back().tick;
+    uint64_t high = session.endTick;
+    while(low < high){
+        replay shorter = session;
+        shorter.endTick = low + (high - low)/2;
+        if(crashes(shorter))
+            high = shorter.endTick;
+        else
+            low = shorter.endTick + 1;
+    }
+    session.endTick = high;
+
+    std::string out = fileName;
+    if(out.size() > 4 && out.compare(out.size() - 4, 4, ".mjr") == 0)
+        out.resize(out.size() - 4);
+    out += ".min.mjr";
+    if(!session.save(out, error)){
+        printf("%s\n", error.c_str());
+        return 2;
+    }
+    printf("%s: %d keys -> %d keys, %llu ticks, written to %s\n", fileName.c_str(), (int)before, (int)session.inputs.size(),
+           (unsigned long long)session.endTick, out.c_str());
+    return 1;
+}
+
+/*! \brief checkReplay
+ *  plays one replay with the checks on, in this process, so a debugger or the sanitizer report shows the crash
+ */
+static int checkReplay(const std::string &fileName){
+    replay session;
+    std::string error;
+    headlessGame game(0);
+    if(!session.load(fileName, error) || !game.begin(session, error)){
+        printf("%s\n", error.c_str());
+        return 2;
+    }
+    do
+        check(game);
+    while(game.advance());
+    printf("%s: played %llu ticks, no problems\n", fileName.c_str(), (unsigned long long)game.ticks());
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+    int workers = std::thread::hardware_concurrency();
+    double seconds = 60;
+    std::string outDir = "crashes";
+    std::vector<std::string> levels;
+    for(int a = 1; a < argc; a++){
+        if(strcmp(argv[a], "-j") == 0 && a + 1 < argc)
+            workers = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-t") == 0 && a + 1 < argc)
+            seconds = atof(argv[++a]);
+        else if(strcmp(argv[a], "-o") == 0 && a + 1 < argc)
+            outDir = argv[++a];
+        else if(strcmp(argv[a], "-check") == 0 && a + 1 < argc)
+            return checkReplay(argv[a + 1]);
+        else if(strcmp(argv[a], "-minimize") == 0 && a + 1 < argc)
+            return minimize(argv[a + 1]);
+        else
+            levels.push_back(argv[a]);
+    }
+    if(levels.empty()){
+        printf("usage: mjfuzz [-j workers] [-t seconds] [-o dir] level...\n"
+               "       mjfuzz -check replay\n"
+               "       mjfuzz -minimize replay\n");
+        return 2;
+    }
+    if(workers < 1)
+        workers = 1;
+    mkdir(outDir.c_str(), 0755);
+
+    fuzzCounters *counters = (fuzzCounters*)mmap(NULL, sizeof(fuzzCounters)*workers, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(counters == MAP_FAILED){
+        perror("mmap");
+        return 2;
+    }
+    memset(counters, 0, sizeof(fuzzCounters)*workers);
+
+    //a worker that dies is replaced by a new one with new numbers until the time is up
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<pid_t> pids(workers, 0);
+    std::vector<std::string> crashFiles;
+    uint32_t nextSeed = (uint32_t)time(NULL);
+    int running = 0;
+    double lastReport = 0;
+    while(true){
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        for(int w = 0; w < workers && elapsed < seconds; w++){
+            if(pids[w] != 0)
+                continue;
+            uint32_t seed = nextSeed++;
+            fflush(stdout);
+            pid_t pid = fork();
+            if(pid == 0){
+                snprintf(crashFile, sizeof(crashFile), "%s/crash-%d.mjr", outDir.c_str(), (int)getpid());
+                catchCrashes();
+                fuzz(w, seed, levels, seconds - elapsed, &counters[w]);
+                _exit(0);
+            }
+            pids[w] = pid;
+            running++;
+        }
+        if(running == 0)
+            break;
+
+        int status;
+        pid_t done = waitpid(-1, &status, WNOHANG);
+        if(done > 0){
+            for(int w = 0; w < workers; w++){
+                if(pids[w] == done){
+                    pids[w] = 0;
+                    running--;
+                }
+            }
+            if(WIFSIGNALED(status) || WEXITSTATUS(status) == 1){
+                char name[512];
+                snprintf(name, sizeof(name), "%s/crash-%d.mjr", outDir.c_str(), (int)done);
+                crashFiles.push_back(name);
+                printf("worker %d crashed, sequence in %s\n", (int)done, name);
+            }
+            else if(WEXITSTATUS(status) != 0){
+                printf("worker %d could not run\n", (int)done);
+                break;
+            }
+            continue;
+        }
+
+        if(elapsed - lastReport >= 5){
+            unsigned long long runs = 0, ticks = 0, kept = 0;
+            for(int w = 0; w < workers; w++){
+                runs += counters[w].runs;
+                ticks += counters[w].ticks;
+                kept += counters[w].corpus;
+            }
+            printf("%6.0f s  %12llu runs  %8.0f runs/s  %8.2f Mticks/s  %8llu kept  %d crashes\n", elapsed, runs,
+                   runs/elapsed, ticks/elapsed/1e6, kept, (int)crashFiles.size());
+            lastReport = elapsed;
+        }
+        usleep(20000);
+    }
+    for(int w = 0; w < workers; w++){
+        if(pids[w] != 0)
+            waitpid(pids[w], NULL, 0);
+    }
+
+    unsigned long long runs = 0, ticks = 0;
+    for(int w = 0; w < workers; w++){
+        runs += counters[w].runs;
+        ticks += counters[w].ticks;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%llu runs, %llu ticks in %.1f s with %d workers, %.0f runs/min\n", runs, ticks, elapsed, workers, runs/elapsed*60);
+
+    for(unsigned int c = 0; c < crashFiles.size(); c++)
+        minimize(crashFiles[c]);
+    return crashFiles.empty() ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#plays random key sequences against the game rules with the sanitizers on, see mjfuzz.cpp. Needs gcc or clang on a unix
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= qt app_bundle
+
+#the core is built in here instead of linking mjcore, so the sanitizers see inside it too
+INCLUDEPATH += $$PWD
+SOURCES += \
+    mjfuzz.cpp \
+    simulation.cpp \
+    workerpool.cpp \
+    levelfile.cpp \
+    levelscanner.cpp \
+    levelbinary.cpp \
+    replay.cpp \
+    headlessgame.cpp \
+    trace.cpp
+
+HEADERS += \
+    simulation.h \
+    workerpool.h \
+    levelfile.h \
+    levelscanner.h \
+    levelbinary.h \
+    gamerandom.h \
+    replay.h \
+    headlessgame.h \
+    trace.h
+
+QMAKE_CXXFLAGS += -g -fno-omit-frame-pointer -fsanitize=address,undefined -fno-sanitize-recover=undefined
+QMAKE_LFLAGS += -fsanitize=address,undefined
+
+TARGET = mjfuzz
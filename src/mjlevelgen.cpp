@@ -0,0 +1,70 @@
+/*! \abstract mjlevelgen
+ *         Writes big generated levels for the game, the editor, bench and the other tools to chew on.
+ *
+ *         mjlevelgen [-s WxH] [-gap rows] [-density percent] [-stairs n] [-mblocks n] [-goods n] [-enemies n] [-doors n]
+ *                    [-chain n] [-seed n] name
+ *
+ *         Run it from the game's folder with a name like levels/big, NEXT and CURRENT are written with the name as given.
+ */
+
+#include "levelgen.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static void usage(){
+    printf("mjlevelgen [-s WxH] [-gap rows] [-density percent] [-stairs n] [-mblocks n] [-goods n] [-enemies n] "
+           "[-doors n] [-chain n] [-seed n] name\n");
+}
+
+int main(int argc, char *argv[]){
+    levelGenOptions options;
+    const char *name = NULL;
+    for(int a = 1; a < argc; a++){
+        bool value = a + 1 < argc;
+        if(strcmp(argv[a], "-s") == 0 && value){
+            if(sscanf(argv[++a], "%dx%d", &options.width, &options.height) != 2){
+                usage();
+                return 1;
+            }
+        }
+        else if(strcmp(argv[a], "-gap") == 0 && value)
+            options.floorGap = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-density") == 0 && value)
+            options.floorDensity = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-stairs") == 0 && value)
+            options.stairs = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-mblocks") == 0 && value)
+            options.mblocks = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-goods") == 0 && value)
+            options.goods = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-enemies") == 0 && value)
+            options.enemies = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-doors") == 0 && value)
+            options.doors = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-chain") == 0 && value)
+            options.chain = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-seed") == 0 && value)
+            options.seed = strtoul(argv[++a], NULL, 10);
+        else if(argv[a][0] != '-' && name == NULL)
+            name = argv[a];
+        else{
+            usage();
+            return 1;
+        }
+    }
+    if(name == NULL){
+        usage();
+        return 1;
+    }
+
+    std::vector<std::string> written;
+    std::string error;
+    if(!generateLevels(options, name, written, error)){
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    for(unsigned int l = 0; l < written.size(); l++)
+        printf("%s\n", written[l].c_str());
+    return 0;
+}
@@ -0,0 +1,7 @@
+#writes big generated levels for testing how everything copes with size
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+include(core.pri)
+SOURCES += mjlevelgen.cpp
+TARGET = mjlevelgen
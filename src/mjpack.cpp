@@ -0,0 +1,187 @@
+/*! \abstract mjpack
+ *         Builds the asset pack the game and the editor read their levels, sprites and sounds from.
+ *
+ *         mjpack [-z] [-o pack] [folder...]    packs every file under the folders, levels sprites and sounds if none
+ *                                              are given, into bakingquest.mjp or pack. -z compresses the entries
+ *                                              that shrink by more than an eighth, the rest are stored as they are
+ *         mjpack -l [pack]                     lists what is in a pack
+ *
+ *         Run it from the game's folder, the names in the pack are the paths from there. Compiled levels are only
+ *         packed when they are up to date with their text, run levelc first to have them in.
+ */
+
+#include <QtCore>
+#include "assetpack.h"
+#include "levelbinary.h"
+#include <algorithm>
+#include <cstdio>
+
+struct packedFile{
+    QString name;
+    QByteArray bytes;
+    quint64 size;
+    quint32 flags;
+};
+
+static bool nameBefore(const packedFile &a, const packedFile &b){
+    return a.name < b.name;
+}
+
+static void usage(){
+    printf("mjpack [-z] [-o pack] [folder...]\nmjpack -l [pack]\n");
+}
+
+static bool writeAll(QFile &out, const char *data, qint64 size){
+    return size == 0 || out.write(data, size) == size;
+}
+
+static int listPack(const QString &packName){
+    QFile pack(packName);
+    if(!pack.open(QIODevice::ReadOnly)){
+        printf("%s: %s\n", qPrintable(packName), qPrintable(pack.errorString()));
+        return 1;
+    }
+    QByteArray bytes = pack.readAll();
+    const assetPackHeader *header = (const assetPackHeader*)bytes.constData();
+    quint64 packSize = bytes.size();
+    if(packSize < sizeof(assetPackHeader) || memcmp(header->magic, ASSETPACK_MAGIC, 4) != 0 ||
+       header->indexOffset > packSize || (quint64)header->count > (packSize - header->indexOffset)/sizeof(assetPackEntry) ||
+       header->namesOffset > packSize || header->namesBytes > packSize - header->namesOffset){
+        printf("%s: not an asset pack\n", qPrintable(packName));
+        return 1;
+    }
+    const assetPackEntry *entries = (const assetPackEntry*)(bytes.constData() + header->indexOffset);
+    const char *names = bytes.constData() + header->namesOffset;
+    for(quint32 e = 0; e < header->count; e++){
+        const assetPackEntry &entry = entries[e];
+        if((quint64)entry.name + entry.nameLength > header->namesBytes)
+            continue;
+        printf("%10llu %10llu %s %s\n", (unsigned long long)entry.size, (unsigned long long)entry.storedSize,
+               entry.flags & ASSETPACK_COMPRESSED ? "z" : "-", QByteArray(names + entry.name, entry.nameLength).constData());
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+    QCoreApplication app(argc, argv);
+    QString packName = ASSETPACK_NAME;
+    QStringList folders;
+    bool compress = false;
+    bool list = false;
+    for(int a = 1; a < argc; a++){
+        QString arg = argv[a];
+        if(arg == "-z")
+            compress = true;
+        else if(arg == "-l")
+            list = true;
+        else if(arg == "-o" && a + 1 < argc)
+            packName = argv[++a];
+        else if(!arg.startsWith("-"))
+            folders.append(arg);
+        else{
+            usage();
+            return 1;
+        }
+    }
+    if(list){
+        if(folders.size() > 1){
+            usage();
+            return 1;
+        }
+        return listPack(folders.isEmpty() ? packName : folders.first());
+    }
+    if(folders.isEmpty())
+        folders << "levels" << "sprites" << "sounds";
+
+    QVector<packedFile> files;
+    for(int f = 0; f < folders.size(); f++){
+        QDirIterator it(folders.at(f), QDir::Files, QDirIterator::Subdirectories);
+        while(it.hasNext()){
+            QString name = QDir::cleanPath(it.next());
+            if(name.startsWith("./"))
+                name = name.mid(2);
+            if(name.endsWith(LEVELBIN_SUFFIX) &&
+               !levelBinary::usable(name.left(name.size() - (int)strlen(LEVELBIN_SUFFIX)).toStdString())){
+                printf("%s: older than its level, left out\n", qPrintable(name));
+                continue;
+            }
+            QFile in(name);
+            if(!in.open(QIODevice::ReadOnly)){
+                printf("%s: %s\n", qPrintable(name), qPrintable(in.errorString()));
+                return 1;
+            }
+            packedFile file;
+            file.name = name;
+            file.bytes = in.readAll();
+            file.size = file.bytes.size();
+            file.flags = 0;
+            if(compress){
+                QByteArray small = qCompress(file.bytes, 9);
+                if((quint64)small.size() < file.size - file.size/8){
+                    file.bytes = small;
+                    file.flags = ASSETPACK_COMPRESSED;
+                }
+            }
+            files.append(file);
+        }
+    }
+    //the same folders give the same pack
+    std::sort(files.begin(), files.end(), nameBefore);
+
+    QFile out(packName);
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+        printf("%s: %s\n", qPrintable(packName), qPrintable(out.errorString()));
+        return 1;
+    }
+    assetPackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ASSETPACK_MAGIC, 4);
+    header.version = ASSETPACK_VERSION;
+    header.count = files.size();
+
+    static const char padding[ASSETPACK_ALIGN] = { 0 };
+    QVector<assetPackEntry> entries;
+    QByteArray names;
+    quint64 at = sizeof(header);
+    bool ok = writeAll(out, (const char*)&header, sizeof(header));
+    quint64 stored = 0;
+    quint64 raw = 0;
+    for(int f = 0; f < files.size() && ok; f++){
+        quint64 aligned = (at + ASSETPACK_ALIGN - 1)/ASSETPACK_ALIGN*ASSETPACK_ALIGN;
+        ok = writeAll(out, padding, aligned - at);
+        at = aligned;
+
+        QByteArray name = files.at(f).name.toUtf8();
+        assetPackEntry entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.name = names.size();
+        entry.nameLength = name.size();
+        entry.offset = at;
+        entry.storedSize = files.at(f).bytes.size();
+        entry.size = files.at(f).size;
+        entry.flags = files.at(f).flags;
+        entries.append(entry);
+        names.append(name);
+
+        ok = ok && writeAll(out, files.at(f).bytes.constData(), entry.storedSize);
+        at += entry.storedSize;
+        stored += entry.storedSize;
+        raw += entry.size;
+    }
+
+    quint64 aligned = (at + ASSETPACK_ALIGN - 1)/ASSETPACK_ALIGN*ASSETPACK_ALIGN;
+    ok = ok && writeAll(out, padding, aligned - at);
+    header.indexOffset = aligned;
+    header.namesOffset = aligned + entries.size()*sizeof(assetPackEntry);
+    header.namesBytes = names.size();
+    ok = ok && writeAll(out, (const char*)entries.constData(), entries.size()*sizeof(assetPackEntry));
+    ok = ok && writeAll(out, names.constData(), names.size());
+    ok = ok && out.seek(0) && writeAll(out, (const char*)&header, sizeof(header));
+    if(!ok){
+        printf("%s: %s\n", qPrintable(packName), qPrintable(out.errorString()));
+        return 1;
+    }
+    printf("%s: %d files, %llu bytes, %llu stored\n", qPrintable(packName), files.size(), (unsigned long long)raw,
+           (unsigned long long)stored);
+    return 0;
+}
@@ -0,0 +1,8 @@
+#packs the levels, sprites and sounds into the one file the game reads them from, see mjpack.cpp
+QT = core
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+include(core.pri)
+SOURCES += mjpack.cpp
+TARGET = mjpack
@@ -0,0 +1,114 @@
+/*! \abstract mjreplay
+ *         Plays replays without a window, as fast as they go, and prints where each one ended up: the level, mj's lives and
+ *         the state hash, which has to be the same every time a replay is played. With -n a replay is played that many times
+ *         to use it as a benchmark. -record file level keys writes a replay that presses the keys (A, D, S for space, R, P)
+ *         one every 5 ticks, e.g. to play back what levelsolver found. -expect level fails a replay that does not end on
+ *         that level, the replays in tests are played that way:
+ *
+ *         mjreplay -expect levels/defaultlevel tests/nonext.mjr
+ */
+
+#include "headlessgame.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define RECORD_TICKS ( 5 )
+
+static int record(const char *fileName, const char *level, const char *keys){
+    uint64_t hash;
+    if(!replay::hashFile(level, hash)){
+        printf("%s: can not open\n", level);
+        return 1;
+    }
+
+    replay session;
+    session.start(0, level, hash);
+    uint64_t tick = 0;
+    for(const char *k = keys; *k; k++){
+        const char *names = "ADSRP";
+        const char *found = strchr(names, *k);
+        if(found == NULL)
+            continue;
+        tick += RECORD_TICKS;
+        session.record(tick, (int)(found - names));
+    }
+    session.finish(tick + RECORD_TICKS);
+
+    std::string error;
+    if(!session.save(fileName, error)){
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+    int repeats = 1;
+    std::string expect;
+    std::vector<std::string> files;
+    for(int a = 1; a < argc; a++){
+        if(strcmp(argv[a], "-n") == 0 && a + 1 < argc)
+            repeats = atoi(argv[++a]);
+        else if(strcmp(argv[a], "-expect") == 0 && a + 1 < argc)
+            expect = argv[++a];
+        else if(strcmp(argv[a], "-record") == 0 && a + 3 < argc)
+            return record(argv[a + 1], argv[a + 2], argv[a + 3]);
+        else
+            files.push_back(argv[a]);
+    }
+    if(files.empty()){
+        printf("usage: mjreplay [-n repeats] [-expect level] replay...\n"
+               "       mjreplay -record replay level keys\n");
+        return 2;
+    }
+    if(repeats < 1)
+        repeats = 1;
+
+    int failed = 0;
+    for(unsigned int f = 0; f < files.size(); f++){
+        replay session;
+        std::string error;
+        if(!session.load(files[f], error)){
+            printf("%s\n", error.c_str());
+            failed++;
+            continue;
+        }
+
+        unsigned long long hash = 0;
+        bool same = true;
+        std::string ended;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int r = 0; r < repeats && error.empty(); r++){
+            headlessGame game(session.seed);
+            if(!game.play(session, error))
+                break;
+            if(r == 0)
+                hash = game.state().stateHash();
+            same = same && game.state().stateHash() == hash;
+            ended = game.levelName();
+            if(r == repeats - 1)
+                printf("%s: %s, %d keys, %llu ticks, %d loads, ends on %s with %d lives, hash %llx\n", files[f].c_str(),
+                       session.level.c_str(), (int)session.inputs.size(), (unsigned long long)game.ticks(), game.loads(),
+                       game.levelName().c_str(), game.state().lives(), hash);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if(!error.empty()){
+            printf("%s\n", error.c_str());
+            failed++;
+        }
+        else if(!same){
+            printf("%s: PLAYS DIFFERENTLY ON THE SAME SEED\n", files[f].c_str());
+            failed++;
+        }
+        else if(!expect.empty() && ended != expect){
+            printf("%s: ENDS ON %s, NOT %s\n", files[f].c_str(), ended.c_str(), expect.c_str());
+            failed++;
+        }
+        else
+            printf("    %.3f s, %.2f Mticks/s\n", seconds, (double)session.endTick*repeats/seconds/1e6);
+    }
+    return failed == 0 ? 0 : 1;
+}
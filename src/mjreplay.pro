@@ -0,0 +1,7 @@
+#plays recorded sessions without a window, to find bugs players report and as a benchmark
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+include(core.pri)
+SOURCES += mjreplay.cpp
+TARGET = mjreplay
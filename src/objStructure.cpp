@@ -1,132 +1,249 @@
 /*! \abstract objStructue
- *         The objStructure class creates a linked list that contains all of the objects loaded in through the parser. In this case, each objectis a node
- *         containing the object type (MJ, good guy, enemy, block, etc.), position, and picture.
+ *         The objStructure class stores all of the objects loaded in through the parser. Each object (MJ, good guy, enemy, block, etc.)
+ *         is one entry in a set of packed arrays, one array per property (type, picture, position, movement, item, sprite), so walking
+ *         every object is a straight pass over memory. Objects are referred to by handles that stay valid until the object is removed.
  */
 
 #include "objStructure.h"
+#include "spritecache.h"
 #include <iostream>
 
-/*! \abstract Node::Node
- *  Fills in the specified elements for objects
- */
-Node::Node(QString type, QString location, int x, int y){
-    blockType = type;
-    this->location = location;
-    this->x = x;
-    this->y = y;
-    this->sprite = NULL;
-}
+static_assert(HANDLE_INDEX_MASK + 1 >= LEVEL_MAX_CELLS, "a handle has to be able to name every cell of the biggest level");
 
-Node::~Node(){
-    if(this->sprite != NULL)
-        delete this->sprite;
+objStructure::objStructure(spriteCache *sprites){
+    this->sprites = sprites;
+    count = 0;
 }
 
-objStructure::objStructure(){
-    count = 0;
-    head = 0;
-    tail = 0;
+/*! \abstract objStructure::reserve
+ *  Makes room for size objects so adding them does not grow the arrays one by one
+ */
+void objStructure::reserve(int size){
+    blockType.reserve(size);
+    location.reserve(size);
+    goodObj.reserve(size);
+    kind.reserve(size);
+    spriteId.reserve(size);
+    itemId.reserve(size);
+    x.reserve(size);
+    y.reserve(size);
+    movement.reserve(size);
+    hasObj.reserve(size);
+    sprite.reserve(size);
+    handles.reserve(size);
+    slotIndex.reserve(size);
+    generation.reserve(size);
 }
 
 /*! \abstract objStructure::add
- *  Adds nodes (objects) to the object list
+ *  Adds an object to the end of the arrays and returns its handle. kind has to be what type says, the parser
+ *  has it already, everyone else goes through the overloads that look it up. Once every slot a handle can
+ *  name is taken nothing is added and -1 is returned
  */
-void objStructure::add(QString type, QString location, int x, int y, QString goodObj){
-    if(count == 0){
-        head = new Node(type, location, x, y);
-        head->prev = 0;
-        head->next = 0;
-        tail = head;
-        head->goodObj = goodObj;
-        count ++;
+int objStructure::add(LevelKeyword kind, const QString &type, const QString &location, int x, int y, const QString &goodObj){
+    if(freeSlots.isEmpty() && slotIndex.size() > HANDLE_INDEX_MASK){
+        std::cout << "objStructure: more than " << HANDLE_INDEX_MASK + 1 << " objects in one list\n";
+        return -1;
     }
-    else if(count == 1){
-        tail = new Node(type, location, x, y);
-        tail->goodObj = goodObj;
-        head->next = tail;
-        tail->prev = head;
-        tail->next = 0;
-        count++;
+    counts.requests++;
+    if(!freeSlots.isEmpty() && count < handles.capacity())
+        counts.hits++;
+
+    int slot;
+    if(!freeSlots.isEmpty()){
+        slot = freeSlots.last();
+        freeSlots.removeLast();
+        generation[slot] = (generation.at(slot) + 1) & HANDLE_GENERATION_MASK;
     }
     else{
-        Node* tmp = new Node(type, location, x, y);
-        tmp->goodObj = goodObj;
-        tmp->prev = tail;
-        tail->next = tmp;
-        tail = tmp;
-        tail->next = 0;
-        count++;
+        slot = slotIndex.size();
+        slotIndex.append(-1);
+        generation.append(0);
     }
+    int handle = (generation.at(slot) << HANDLE_INDEX_BITS) | slot;
+
+    slotIndex[slot] = count;
+    handles.append(handle);
+    blockType.append(type);
+    this->location.append(location);
+    this->goodObj.append(goodObj);
+    this->kind.append(kind);
+    spriteId.append(sprites != NULL ? sprites->id(location) : -1);
+    itemId.append(sprites != NULL && !goodObj.isEmpty() ? sprites->id(goodObj) : -1);
+    this->x.append(x);
+    this->y.append(y);
+    movement.append(0);
+    hasObj.append(false);
+    sprite.append(NULL);
+    count++;
+    counts.highWater = qMax(counts.highWater, count);
+
+    return handle;
 }
 
-void objStructure::add(QString type, QString location, int x, int y){
-    if(count == 0){
-        head = new Node(type, location, x, y);
-        head->prev = 0;
-        head->next = 0;
-        tail = head;
-        count ++;
-    }
-    else if(count == 1){
-        tail = new Node(type, location, x, y);
-        head->next = tail;
-        tail->prev = head;
-        tail->next = 0;
-        count++;
-    }
-    else{
-        Node* tmp = new Node(type, location, x, y);
-        tmp->prev = tail;
-        tail->next = tmp;
-        tail = tmp;
-        tail->next = 0;
-        count++;
-    }
+int objStructure::add(QString type, QString location, int x, int y, QString goodObj){
+    QByteArray name = type.toLatin1();
+    return add(levelScanner::keyword(name.constData(), name.size()), type, location, x, y, goodObj);
+}
+
+int objStructure::add(QString type, QString location, int x, int y){
+    return add(type, location, x, y, QString());
 }
 
 /*! \abstract objStructure::remove
- *  removes nodes (objects) from the object list
+ *  removes an object, and its sprite, the last object is moved into the free spot
  */
-void objStructure::remove(Node *gone){
-    //one node in list
-    if(head == gone && tail == gone){
-        head = NULL;
-        tail = NULL;
-        gone->~Node();
-    }
+void objStructure::remove(int handle){
+    int i = indexOf(handle);
+    if(i == -1)
+        return;
 
-    //gone is head
-    else if( head == gone){
-        head = head->next;
-        head->prev = NULL;
-        gone->~Node();
-    }
-    //gone is tail
-    else if(tail == gone){
-        tail = tail->prev;
-        tail->next = NULL;
-        gone->~Node();
-    }
-    //gone is other node
-    else{
-        gone->prev->next = gone->next;
-        gone->next->prev = gone->prev;
-        gone->~Node();
+    delete sprite.at(i);
+
+    int last = count - 1;
+    if(i != last){
+        blockType[i] = blockType.at(last);
+        location[i] = location.at(last);
+        goodObj[i] = goodObj.at(last);
+        kind[i] = kind.at(last);
+        spriteId[i] = spriteId.at(last);
+        itemId[i] = itemId.at(last);
+        x[i] = x.at(last);
+        y[i] = y.at(last);
+        movement[i] = movement.at(last);
+        hasObj[i] = hasObj.at(last);
+        sprite[i] = sprite.at(last);
+        handles[i] = handles.at(last);
+        slotIndex[handles.at(i) & HANDLE_INDEX_MASK] = i;
     }
+
+    blockType.removeLast();
+    location.removeLast();
+    goodObj.removeLast();
+    kind.removeLast();
+    spriteId.removeLast();
+    itemId.removeLast();
+    this->x.removeLast();
+    this->y.removeLast();
+    movement.removeLast();
+    hasObj.removeLast();
+    sprite.removeLast();
+    handles.removeLast();
+
+    int slot = handle & HANDLE_INDEX_MASK;
+    slotIndex[slot] = -1;
+    freeSlots.append(slot);
     count--;
 }
 
 /*! \abstract objStructure::removeAll
- *  removes all nodes (objects) from the object list
+ *  removes all objects, the arrays keep their room for the next level
  */
 void objStructure::removeAll(){
-    while(count>0)
-        remove(head);
+    for(int i = 0; i < count; i++)
+        delete sprite.at(i);
+
+    blockType.resize(0);
+    location.resize(0);
+    goodObj.resize(0);
+    kind.resize(0);
+    spriteId.resize(0);
+    itemId.resize(0);
+    x.resize(0);
+    y.resize(0);
+    movement.resize(0);
+    hasObj.resize(0);
+    sprite.resize(0);
+    handles.resize(0);
+
+    //every handle handed out so far goes stale
+    freeSlots.resize(0);
+    for(int slot = slotIndex.size() - 1; slot >= 0; slot--){
+        slotIndex[slot] = -1;
+        freeSlots.append(slot);
+    }
+    count = 0;
+}
+
+template<typename T> static void copyInto(QVector<T> &to, const QVector<T> &from){
+    to.resize(from.size());
+    for(int i = 0; i < from.size(); i++)
+        to[i] = from.at(i);
+}
+
+/*! \abstract objStructure::copyFrom
+ *  copies every object of from, with its handle, element by element. Unlike operator= the arrays are not shared with
+ *  from, so they keep their room and moving an object later doesn't have to copy a whole array first
+ */
+void objStructure::copyFrom(const objStructure &from){
+    if(&from == this)
+        return;
+    counts.requests += from.count;
+    counts.hits += qMin(from.count, handles.capacity());
+
+    copyInto(blockType, from.blockType);
+    copyInto(location, from.location);
+    copyInto(goodObj, from.goodObj);
+    copyInto(kind, from.kind);
+    copyInto(spriteId, from.spriteId);
+    copyInto(itemId, from.itemId);
+    copyInto(x, from.x);
+    copyInto(y, from.y);
+    copyInto(movement, from.movement);
+    copyInto(hasObj, from.hasObj);
+    copyInto(sprite, from.sprite);
+    copyInto(handles, from.handles);
+    copyInto(slotIndex, from.slotIndex);
+    copyInto(generation, from.generation);
+    copyInto(freeSlots, from.freeSlots);
+    count = from.count;
+    counts.highWater = qMax(counts.highWater, count);
+}
+
+/*! \abstract objStructure::setSprites
+ *  for lists filled without a spriteCache, like the ones levelPrefetch fills on its own thread
+ */
+void objStructure::setSprites(spriteCache *sprites){
+    this->sprites = sprites;
+    for(int i = 0; i < count; i++){
+        spriteId[i] = sprites->id(location.at(i));
+        itemId[i] = goodObj.at(i).isEmpty() ? -1 : sprites->id(goodObj.at(i));
+    }
+}
+
+poolStats objStructure::stats() const{
+    poolStats current = counts;
+    current.live = count;
+    return current;
 }
 
 /*! \abstract objStructure::getCount
- *  counts nodes in the object list
+ *  counts objects in the list
  */
 int objStructure::getCount(){
     return count;
 }
+
+/*! \abstract objStructure::isValid
+ *  true while the object the handle points to has not been removed
+ */
+bool objStructure::isValid(int handle){
+    return indexOf(handle) != -1;
+}
+
+/*! \abstract objStructure::indexOf
+ *  returns where the object is in the arrays right now, or -1 if it was removed
+ */
+int objStructure::indexOf(int handle){
+    if(handle < 0)
+        return -1;
+
+    int slot = handle & HANDLE_INDEX_MASK;
+    if(slot >= slotIndex.size() || generation.at(slot) != (handle >> HANDLE_INDEX_BITS))
+        return -1;
+    return slotIndex.at(slot);
+}
+
+int objStructure::handleAt(int index){
+    return handles.at(index);
+}
@@ -3,40 +3,68 @@
 #include <QtCore>
 #include "objects.h"
 #include "definitions.h"
+#include "levelscanner.h"
 
-class Node{
-public:
-    QGraphicsRectWidget *sprite;
-    QString blockType;
-    QString location;
-    QString goodObj;
-    int x;
-    int y;
-    int movement;
-    bool hasObj;
-    Node *next;
-    Node *prev;
-    Node();
-    ~Node();
-    Node(QString type, QString location, int x, int y);
-};
+class spriteCache;
+
+/* a handle keeps pointing at the same object until it is removed, the low bits pick a slot and
+   the high bits are the slot's generation so a handle to a removed object is never valid again.
+   There are enough slots for an object in every cell of the biggest level, LEVEL_MAX_CELLS, a list
+   that would need more refuses the add.
+   That leaves 7 bits of generation in a positive int: after 128 reuses of one slot a handle that went stale
+   128 reuses ago points at the slot's object again. Slots are reused once per level load after removeAll
+   and the engine drops every handle it holds on a load (simLinks, mj, the snapshot), so nothing keeps a
+   handle long enough for that. Keep it that way, or make handles 64 bit */
+#define HANDLE_INDEX_BITS ( 24 )
+#define HANDLE_INDEX_MASK ( (1 << HANDLE_INDEX_BITS) - 1 )
+#define HANDLE_GENERATION_MASK ( 0x7F )
 
 class objStructure
 {
 public:
-    objStructure();
+    //with a spriteCache every object also gets the ids of its pictures
+    objStructure(spriteCache *sprites = NULL);
     //~objStructure();
-    void add(QString type, QString location,int x, int y);
-    void add(QString type, QString location, int x, int y, QString goodObj);
-    void remove(QString type, int x, int y);
-    void remove(Node *gone);
+    int add(QString type, QString location,int x, int y);
+    int add(QString type, QString location, int x, int y, QString goodObj);
+    //-1 when the list has no slot left for it
+    int add(LevelKeyword kind, const QString &type, const QString &location, int x, int y, const QString &goodObj);
+    void remove(int handle);
     void removeAll();
+    //makes the list the same as from, handles included, into the arrays it has. the counters stay its own
+    void copyFrom(const objStructure &from);
+    void reserve(int size);
     int getCount();
-    Node *head;
-    Node *tail;
+    bool isValid(int handle);
+    int indexOf(int handle);
+    int handleAt(int index);
+    //gives the list a spriteCache and looks up the ids of everything already in it
+    void setSprites(spriteCache *sprites);
+    //the list is a pool of slots, an add is a hit when it reused a slot and the arrays had room for it
+    poolStats stats() const;
+
+    //one entry per object, packed at 0..getCount()-1. removing an object moves the last one into its place
+    QVector<QString> blockType;
+    QVector<QString> location;
+    QVector<QString> goodObj;
+    //the type and pictures looked up once when added, the names above are only for saving and the editor
+    QVector<LevelKeyword> kind;
+    QVector<int> spriteId;     //location as a spriteCache id, -1 without a cache
+    QVector<int> itemId;       //goodObj the same way, -1 if there is none
+    QVector<int> x;
+    QVector<int> y;
+    QVector<int> movement;
+    QVector<bool> hasObj;
+    QVector<QGraphicsRectWidget*> sprite;
 
 private:
+    spriteCache *sprites;
     int count;
+    QVector<int> handles;      //packed index -> handle
+    QVector<int> slotIndex;    //slot -> packed index, -1 when free
+    QVector<int> generation;   //slot -> times it was handed out
+    QVector<int> freeSlots;
+    poolStats counts;
 };
 
 #endif // OBJSTRUCTURE_H
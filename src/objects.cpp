@@ -3,30 +3,89 @@
  */
 
 #include "objects.h"
+#include "assets.h"
 
 QGraphicsRectWidget::~QGraphicsRectWidget(){
-    delete brush;
-    delete size;
 }
 
 QGraphicsRectWidget::QGraphicsRectWidget(){
-    brush = new QBrush(Qt::gray,Qt::SolidPattern);
-    size = new QRect();
+    brush = QBrush(Qt::gray,Qt::SolidPattern);
 }
 
 QGraphicsRectWidget::QGraphicsRectWidget(Qt::GlobalColor color, int blockWidth, int blockHeight){
-    brush = new QBrush(color,Qt::SolidPattern);
-    size = new QRect(0,0, blockWidth, blockHeight);
+    brush = QBrush(color,Qt::SolidPattern);
+    size = QRect(0,0, blockWidth, blockHeight);
 }
 
 QGraphicsRectWidget::QGraphicsRectWidget(QPixmap pMap, int blockWidth, int blockHeight){
-    brush = new QBrush(pMap);
-    size = new QRect(0,0, blockWidth, blockHeight);
+    brush = QBrush(pMap);
+    size = QRect(0,0, blockWidth, blockHeight);
+}
+
+QGraphicsRectWidget::QGraphicsRectWidget(const QBrush &spriteBrush, int blockWidth, int blockHeight){
+    brush = spriteBrush;
+    size = QRect(0,0, blockWidth, blockHeight);
 }
 
 QGraphicsRectWidget::QGraphicsRectWidget(const char* spriteName, int blockWidth, int blockHeight){
-    brush= new QBrush( QPixmap(spriteName) );
-    size = new QRect(0,0, blockWidth, blockHeight);
+    brush = QBrush( assets().pixmap(spriteName) );
+    size = QRect(0,0, blockWidth, blockHeight);
+}
+
+/*! \brief QGraphicsRectWidget::setSpriteBrush
+ *  swaps the picture shown, the brush is shared so nothing gets decoded or leaked
+ */
+void QGraphicsRectWidget::setSpriteBrush(const QBrush &spriteBrush){
+    brush = spriteBrush;
+    update();
+}
+
+/*! \brief QGraphicsRectWidget::reuse
+ *  undoes what the game and the editor change on a widget, the position too since MoveBlock moves by an offset
+ */
+void QGraphicsRectWidget::reuse(const QBrush &spriteBrush, int blockWidth, int blockHeight){
+    brush = spriteBrush;
+    size = QRect(0,0, blockWidth, blockHeight);
+    setPos(0, 0);
+    setZValue(0);
+    setFlag(QGraphicsItem::ItemIsMovable, false);
+    unsetCursor();
+    show();
+}
+
+spritePool::spritePool(){
+}
+
+spritePool::~spritePool(){
+    qDeleteAll(spare);
+}
+
+/*! \brief spritePool::take
+ *  a widget given back before if there is one, a new one otherwise
+ */
+QGraphicsRectWidget *spritePool::take(const QBrush &spriteBrush, int blockWidth, int blockHeight){
+    QGraphicsRectWidget *widget;
+    counts.requests++;
+    if(!spare.isEmpty()){
+        widget = spare.takeLast();
+        widget->reuse(spriteBrush, blockWidth, blockHeight);
+        counts.hits++;
+    }
+    else
+        widget = new QGraphicsRectWidget(spriteBrush, blockWidth, blockHeight);
+    counts.live++;
+    counts.highWater = qMax(counts.highWater, counts.live);
+    return widget;
+}
+
+void spritePool::give(QGraphicsRectWidget *widget){
+    if(widget == NULL)
+        return;
+    if(widget->scene() != NULL)
+        widget->scene()->removeItem(widget);
+    spare.append(widget);
+    if(counts.live > 0)
+        counts.live--;
 }
 
 /************************Not Used Right now****************************************************
@@ -11,21 +11,52 @@
 
 class QGraphicsRectWidget : public QGraphicsWidget{
 
-    //QBrush *brush;
-    QRect *size;
+    QRect size;
 public:
-    QBrush *brush;
+    //brushes are implicitly shared, widgets showing the same sprite share one pixmap
+    QBrush brush;
     QGraphicsRectWidget();
     ~QGraphicsRectWidget();
     QGraphicsRectWidget(Qt::GlobalColor color, int blockWidth, int blockHeight);
     QGraphicsRectWidget(QPixmap pMap, int blockWidth, int blockHeight);
+    QGraphicsRectWidget(const QBrush &spriteBrush, int blockWidth, int blockHeight);
     QGraphicsRectWidget(const char* spriteName, int blockWidth, int blockHeight);
 
+    void setSpriteBrush(const QBrush &spriteBrush);
+    //makes a used widget look like a new one showing spriteBrush
+    void reuse(const QBrush &spriteBrush, int blockWidth, int blockHeight);
+
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *, QWidget *){
-        painter->fillRect(*size, *brush);
+        painter->fillRect(size, brush);
     }
 };
 
+/* how a pool is doing. requests counts every object asked for, hits the ones that were recycled instead of
+   allocated, highWater is the most that were out at once */
+struct poolStats{
+    quint64 requests;
+    quint64 hits;
+    int live;
+    int highWater;
+    poolStats() : requests(0), hits(0), live(0), highWater(0) {}
+};
+
+/* widgets given back when a level is cleared, the next level takes them instead of making new ones. A widget
+   given back is taken out of its scene, take() hands it out like a new one that still has to be added to one */
+class spritePool{
+public:
+    spritePool();
+    ~spritePool();
+    QGraphicsRectWidget *take(const QBrush &spriteBrush, int blockWidth, int blockHeight);
+    //NULL is fine
+    void give(QGraphicsRectWidget *widget);
+    poolStats stats() const { return counts; }
+
+private:
+    QVector<QGraphicsRectWidget*> spare;
+    poolStats counts;
+};
+
 /* is the custom implementation of a graphicsview to handle mouse stuff */
 class GraphicsView : public QGraphicsView
   {
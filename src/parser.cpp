@@ -4,13 +4,24 @@
  */
 
 #include "parser.h"
+#include "levelscanner.h"
+#include "levelbinary.h"
+#include "assets.h"
+#include "trace.h"
 #include <iostream>
 
+//sprite names remembered while reading a level, a level with more than this makes a string for each of the rest
+#define PARSER_NAMES ( 64 )
+
 parser::parser(){
     //default case
     lives = 3;
+    width = GRID_WIDTH;
+    height = GRID_HEIGHT;
     curLevel = "levels/defaultlevel";
     nextLevel = "levels/defaultlevel";
+    sprites = NULL;
+    file = NULL;
 }
 parser::~parser(){
     delete sprites;
@@ -18,139 +29,185 @@ parser::~parser(){
 
 /*! \abstract parser::readFile
  * Reads a file, either one specified by user though the file dialog or opens the
- * name specified add sprites to the objStructure
+ * name specified add sprites to the objStructure. The file is mapped and read by levelScanner,
+ * lines it can't make sense of are skipped and printed with their line number. A level compiled by levelc
+ * is used instead of the text when it is there and up to date. Levels in the asset pack are read from it
  */
 int parser::readFile( QWidget *parent, objStructure *good, objStructure *enemies,
                       objStructure *blocks, objStructure *doors, objStructure *other, QString fileName){
+    TRACE_SCOPE("parse");
     //the default value
     lives = 3;
+    width = GRID_WIDTH;
+    height = GRID_HEIGHT;
+
+    QString name = fileName;
     //Opens a file chooser Dialog box
-    if( fileName.isNull() ){
+    if( name.isNull() ){
         /* Without putting a parentwindow reference, the dialogBox will background everything */
-        QFile file(QFileDialog::getOpenFileName( parent , "Open Level", "", "Files (*.*)"));
+        name = QFileDialog::getOpenFileName( parent , "Open Level", "", "Files (*.*)");
 
         //if the file can't be opened, then load the default map
-        if(!file.open(QIODevice::ReadOnly)){
-            QMessageBox::information( parent, "Error!",file.fileName()+" : "+ file.errorString()+"\nLoading Default");
-            file.setFileName("levels/defaultlevel");
-            file.open(QIODevice::ReadOnly);
+        QFile chosen(name);
+        if(!assets().contains(name) && !chosen.open(QIODevice::ReadOnly)){
+            QMessageBox::information( parent, "Error!",name+" : "+ chosen.errorString()+"\nLoading Default");
+            name = "levels/defaultlevel";
         }
-        QTextStream in(&file);
-        //process each line of the file and take appropiate actions
-
-        while(!in.atEnd()) {
-            QString line = in.readLine();
-            //a comment is encountered
-            if(line.contains('#'))
-                continue;
-
-            QStringList fields = line.split(",");
-
-            QString spriteName("");
-            spriteName.append(fields.at(1).trimmed());
-
-            if(fields.at(0).compare( QString("MJ")) == 0){
-                good->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("GOOD")) == 0){
-                good->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt(), fields.at(4).trimmed());
-            }
-            else if(fields.at(0).compare( QString("ENEMY")) == 0 ){
-                enemies->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("BLOCK")) == 0 || fields.at(0).compare( QString("MBLOCK")) == 0 ){
-                 blocks->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("DOOR")) == 0){
-                 doors->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("NEXT")) == 0){
-                nextLevel = fields.at(1).trimmed();
-            }
-            else if(fields.at(0).compare( QString("LIVES")) == 0){
-                lives = fields.at(1).trimmed().toInt();
-            }
-            else if(fields.at(0).compare( QString("CURRENT")) == 0){
-                curLevel = fields.at(1).trimmed();
-            }
-            else{
-
-                if(fields.at(0).compare( QString("BACKGROUND")) == 0 )
-                    other->add(fields.at(0), spriteName, -1, -1);
-                else{
-                    std::cout << fields.at(2).toInt() << std::endl;
-                    other->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-                }
-            }
+    }
 
+    //a pack is built with only the compiled levels that were up to date
+    QByteArray packedBinary;
+    std::string textName = name.toStdString();
+    levelBinary binary;
+    std::string error;
+    if(assets().packed(name + LEVELBIN_SUFFIX, packedBinary)){
+        if(binary.use(packedBinary.constData(), packedBinary.size(), error)){
+            return readBinary(binary, good, enemies, blocks, doors, other) ? 0 : -1;
+        }
+        std::cout << textName << LEVELBIN_SUFFIX << ": " << error << ", reading the text instead\n";
+    }
+    else if(levelBinary::usable(textName)){
+        if(binary.open(levelBinary::binaryName(textName), error)){
+            return readBinary(binary, good, enemies, blocks, doors, other) ? 0 : -1;
         }
-        file.close();
-        return 0;
+        std::cout << error << ", reading the text instead\n";
     }
 
-    //loads level specified in filename
+    //packed, or mapped when the platform can, read in one go when it can't
+    QFile file(name);
+    QByteArray bytes;
+    const char *data = NULL;
+    qint64 size = 0;
+    if(assets().packed(name, bytes)){
+        data = bytes.constData();
+        size = bytes.size();
+    }
     else{
-        QFile file( fileName );
         if(!file.open(QIODevice::ReadOnly))
             return -1;
+        size = file.size();
+        data = (const char*)file.map(0, size);
+        if(data == NULL){
+            bytes = file.readAll();
+            data = bytes.constData();
+            size = bytes.size();
+        }
+    }
+    levelScanner scanner(data, size);
 
-        QTextStream in(&file);
-        //process each line of the file and take appropiate actions
-        while(!in.atEnd()) {
+    //the type names are shared, sprite names are looked up in the first PARSER_NAMES seen so a level of a
+    //thousand woodfloors makes one string
+    static const QString keywords[LEVEL_OTHER] = { "MJ", "GOOD", "ENEMY", "BLOCK", "MBLOCK", "DOOR", "NEXT", "CURRENT",
+                                                   "LIVES", "SIZE", "BACKGROUND" };
+    QVector<levelField> seenFields;
+    QVector<QString> seenNames;
 
-            QString line = in.readLine();
-            //a comment is encountered
-            if(line.contains('#'))
-                continue;
+    levelLine line;
+    while(scanner.next(line)){
+        if(line.keyword == LEVEL_NEXT){
+            nextLevel = QString::fromUtf8(line.text.text, line.text.length);
+            continue;
+        }
+        if(line.keyword == LEVEL_CURRENT){
+            curLevel = QString::fromUtf8(line.text.text, line.text.length);
+            continue;
+        }
+        if(line.keyword == LEVEL_LIVES){
+            lives = line.x;
+            continue;
+        }
+        if(line.keyword == LEVEL_SIZE){
+            width = line.x;
+            height = line.y;
+            continue;
+        }
 
-            QStringList fields = line.split(",");
+        QString type = line.keyword == LEVEL_OTHER ? QString::fromUtf8(line.type.text, line.type.length) : keywords[line.keyword];
+        QString spriteName;
+        int seen = 0;
+        while(seen < seenFields.size() && !seenFields.at(seen).equals(line.text))
+            seen++;
+        if(seen < seenFields.size())
+            spriteName = seenNames.at(seen);
+        else{
+            spriteName = QString::fromUtf8(line.text.text, line.text.length);
+            if(seenFields.size() < PARSER_NAMES){
+                seenFields.append(line.text);
+                seenNames.append(spriteName);
+            }
+        }
 
-            QString spriteName("");
-            spriteName.append(fields.at(1).trimmed());
+        int handle;
+        if(line.keyword == LEVEL_MJ)
+            handle = good->add(line.keyword, type, spriteName, line.x, line.y, QString());
+        else if(line.keyword == LEVEL_GOOD){
+            handle = good->add(line.keyword, type, spriteName, line.x, line.y, QString::fromUtf8(line.item.text, line.item.length));
+            if(handle != -1)
+                good->hasObj[good->indexOf(handle)] = line.hasItem == 1;
+        }
+        else if(line.keyword == LEVEL_ENEMY)
+            handle = enemies->add(line.keyword, type, spriteName, line.x, line.y, QString());
+        else if(line.keyword == LEVEL_BLOCK || line.keyword == LEVEL_MBLOCK)
+            handle = blocks->add(line.keyword, type, spriteName, line.x, line.y, QString());
+        else if(line.keyword == LEVEL_DOOR)
+            handle = doors->add(line.keyword, type, spriteName, line.x, line.y, QString());
+        else
+            handle = other->add(line.keyword, type, spriteName, line.x, line.y, QString());
+        if(handle == -1){
+            std::cout << textName << ": line " << line.number << ": too many objects, the level can't be read\n";
+            return -1;
+        }
+    }
 
-            if(fields.at(0).compare( QString("MJ")) == 0){
-                good->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("GOOD")) == 0){
-                good->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt(), fields.at(4).trimmed());
+    for(unsigned int e = 0; e < scanner.errors.size(); e++)
+        std::cout << textName << ": " << scanner.errors[e] << "\n";
+    return 0;
+}
 
-                if(fields.at(5).trimmed().toInt() == 0)
-                    good->tail->hasObj = false;
-                else if(fields.at(5).trimmed().toInt() == 1)
-                    good->tail->hasObj = true;
-            }
-            else if(fields.at(0).compare( QString("ENEMY")) == 0 ){
-                enemies->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("BLOCK")) == 0 || fields.at(0).compare( QString("MBLOCK")) == 0 ){
-                 blocks->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("DOOR")) == 0){
-                 doors->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-            }
-            else if(fields.at(0).compare( QString("NEXT")) == 0){
-                nextLevel = fields.at(1).trimmed();
-            }
-            else if(fields.at(0).compare( QString("LIVES")) == 0){
-                lives = fields.at(1).trimmed().toInt();
+/*! \abstract parser::readBinary
+ * Fills the objStructures from a compiled level. Each string in its table becomes one QString, the records
+ * are already split into the lists they go in. False if a list ran out of handles
+ */
+bool parser::readBinary(const levelBinary &binary, objStructure *good, objStructure *enemies,
+                        objStructure *blocks, objStructure *doors, objStructure *other){
+    const levelBinaryHeader &header = binary.header();
+    lives = header.lives;
+    width = header.width;
+    height = header.height;
+    //a level compiled without NEXT or CURRENT keeps the names from before it, like the text does
+    if(*binary.string(header.next) != '\0')
+        nextLevel = QString::fromUtf8(binary.string(header.next));
+    if(*binary.string(header.current) != '\0')
+        curLevel = QString::fromUtf8(binary.string(header.current));
+
+    QVector<QString> names(header.stringCount);
+    for(uint32_t s = 0; s < header.stringCount; s++)
+        names[s] = QString::fromUtf8(binary.string(s));
+    QVector<QString> keywords(LEVEL_OTHER);
+    for(int k = 0; k < LEVEL_OTHER; k++)
+        keywords[k] = levelScanner::keywordName((LevelKeyword)k);
+
+    objStructure *lists[GROUP_COUNT] = { good, enemies, blocks, doors, other };
+    for(int g = 0; g < GROUP_COUNT; g++){
+        lists[g]->reserve(lists[g]->getCount() + binary.count(g));
+        for(int i = 0; i < binary.count(g); i++){
+            const levelRecord &r = binary.record(g, i);
+            const QString &type = r.keyword == LEVEL_OTHER ? names[r.extra] : keywords[r.keyword];
+            int handle;
+            if(r.keyword == LEVEL_GOOD){
+                handle = good->add(LEVEL_GOOD, type, names[r.sprite], r.x, r.y, names[r.extra]);
+                if(handle != -1)
+                    good->hasObj[good->indexOf(handle)] = r.hasObj != 0;
             }
-            else if(fields.at(0).compare( QString("CURRENT")) == 0){
-                curLevel = fields.at(1).trimmed();
+            else
+                handle = lists[g]->add((LevelKeyword)r.keyword, type, names[r.sprite], r.x, r.y, QString());
+            if(handle == -1){
+                std::cout << "too many objects in group " << g << " of a compiled level, it can't be read\n";
+                return false;
             }
-            else{
-                if(fields.at(0).compare( QString("BACKGROUND")) == 0 )
-                    other->add(fields.at(0), spriteName, -1, -1);
-                else{
-                    other->add(fields.at(0), spriteName, fields.at(2).toInt(), fields.at(3).toInt());
-                }
-           }
         }
-        file.close();
-        return 0;
     }
-
-    //something broke if it gets down here
-    return 1;
+    return true;
 }
 
 /*! \abstract parser::createFile
@@ -159,6 +216,7 @@ int parser::readFile( QWidget *parent, objStructure *good, objStructure *enemies
  */
 void parser::createFile(const QString name,  objStructure *goodGuys, objStructure *enemies,
                         objStructure *blocks, objStructure *doors, objStructure *other){
+    TRACE_SCOPE("save file");
 
     if(!QDir().exists("saved"))
         QDir().mkdir("saved");
@@ -172,43 +230,31 @@ void parser::createFile(const QString name,  objStructure *goodGuys, objStructur
     out << "LIVES, " << lives << "\n";
     out << "NEXT, " << nextLevel << "\n";
     out << "CURRENT, " << curLevel << "\n";
+    out << "SIZE, " << width << ", " << height << "\n";
     out <<"#Level atributes\n";
 
-    Node *tmp = goodGuys->head;
-    while(tmp != 0){
-        out << tmp->blockType << ", " << tmp->location << ", " << tmp->x << ", " << tmp->y;
-        if(tmp->blockType.compare(QString("MJ")) != 0)
-            out << ", " << tmp->goodObj << ", " << tmp->hasObj;
+    for(int i = 0; i < goodGuys->getCount(); i++){
+        out << goodGuys->blockType.at(i) << ", " << goodGuys->location.at(i) << ", " << goodGuys->x.at(i) << ", " << goodGuys->y.at(i);
+        if(goodGuys->kind.at(i) != LEVEL_MJ)
+            out << ", " << goodGuys->goodObj.at(i) << ", " << goodGuys->hasObj.at(i);
         out << "\n";
-        tmp = tmp->next;
     }
 
-    tmp = enemies->head;
-    while(tmp != 0){
-        out << tmp->blockType << ", " << tmp->location << ", " << tmp->x << ", " << tmp->y <<"\n";
-        tmp = tmp->next;
-    }
+    for(int i = 0; i < enemies->getCount(); i++)
+        out << enemies->blockType.at(i) << ", " << enemies->location.at(i) << ", " << enemies->x.at(i) << ", " << enemies->y.at(i) <<"\n";
 
-    tmp = doors->head;
-    while(tmp != 0){
-        out << tmp->blockType << ", " << tmp->location << ", " << tmp->x << ", " << tmp->y <<"\n";
-        tmp = tmp->next;
-    }
+    for(int i = 0; i < doors->getCount(); i++)
+        out << doors->blockType.at(i) << ", " << doors->location.at(i) << ", " << doors->x.at(i) << ", " << doors->y.at(i) <<"\n";
 
-    tmp = blocks->head;
-    while(tmp != 0){
-        out << tmp->blockType << ", " << tmp->location << ", " << tmp->x << ", " << tmp->y <<"\n";
-        tmp = tmp->next;
-    }
+    for(int i = 0; i < blocks->getCount(); i++)
+        out << blocks->blockType.at(i) << ", " << blocks->location.at(i) << ", " << blocks->x.at(i) << ", " << blocks->y.at(i) <<"\n";
 
-    tmp = other->head;
-    while(tmp != 0){
-        if(tmp->blockType.compare( QString("BACKGROUND")) == 0)
-            out << tmp->blockType << ", " << tmp->location <<"\n";
+    for(int i = 0; i < other->getCount(); i++){
+        if(other->kind.at(i) == LEVEL_BACKGROUND)
+            out << other->blockType.at(i) << ", " << other->location.at(i) <<"\n";
         else{
-            out << tmp->blockType << ", " << tmp->location << ", " << tmp->x << ", " << tmp->y <<"\n";
+            out << other->blockType.at(i) << ", " << other->location.at(i) << ", " << other->x.at(i) << ", " << other->y.at(i) <<"\n";
         }
-        tmp = tmp->next;
     }
 
     file.close();
@@ -5,8 +5,11 @@
 #include <QtGui>
 
 #include "objStructure.h"
+#include "simulation.h"
 #include "definitions.h"
 
+class levelBinary;
+
 class parser
 {
 public:
@@ -18,10 +21,15 @@ public:
     QString curLevel;
     QString nextLevel;
     int lives;
+    //size of the level in blocks, SIZE in the level file
+    int width;
+    int height;
 private:
     objStructure* sprites;
     QFile *file;
     int processFile(QFile *file );
+    bool readBinary(const levelBinary &binary, objStructure *good, objStructure *enemies, objStructure *blocks,
+                    objStructure *doors, objStructure *other);
 };
 
 #endif // PARSER_H
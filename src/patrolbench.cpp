@@ -0,0 +1,88 @@
+/*! \abstract patrolbench
+ *         Times the npc patrol one at a time and split over threads, for 1k, 10k and 100k npcs (or the counts given on
+ *         the command line, -t sets the threads). The field is rows of floor with holes in them so npcs both walk and
+ *         turn around. Every run starts from the same field and the state hashes they end with have to match, so this
+ *         is also the check that the threaded patrol is deterministic.
+ */
+
+#include "simulation.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#define BENCH_WIDTH ( 1024 )
+
+//a floor every other row with one hole in ten, npcs spread over the open cells
+static void buildField(simulation &sim, int npcs){
+    int floors = npcs/(BENCH_WIDTH/2) + 1;
+    sim.clear(BENCH_WIDTH, floors*2 + 1);
+    srand(1);
+
+    for(int f = 0; f < floors; f++){
+        for(int x = 0; x < BENCH_WIDTH; x++){
+            if(rand() % 10 != 0)
+                sim.addEntity(KIND_BLOCK, x, f*2 + 1);
+        }
+    }
+    for(int i = 0; i < npcs; i++){
+        int f = i/(BENCH_WIDTH/2);
+        int x = (i % (BENCH_WIDTH/2))*2;
+        sim.addEntity(i % 2 ? KIND_ENEMY : KIND_GOOD, x, f*2 + 2, rand() % 2);
+    }
+}
+
+//runs ticks patrol steps and returns npc updates per second
+static double run(simulation &sim, int npcs, int ticks){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(int t = 0; t < ticks; t++){
+        sim.clearEvents();
+        sim.moveEnemies();
+        sim.moveGood();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return (double)npcs*ticks/seconds;
+}
+
+int main(int argc, char *argv[]){
+    int threads = std::thread::hardware_concurrency();
+    std::vector<int> counts;
+    for(int a = 1; a < argc; a++){
+        if(strcmp(argv[a], "-t") == 0 && a + 1 < argc)
+            threads = atoi(argv[++a]);
+        else
+            counts.push_back(atoi(argv[a]));
+    }
+    if(counts.empty()){
+        counts.push_back(1000);
+        counts.push_back(10000);
+        counts.push_back(100000);
+    }
+    if(threads < 1)
+        threads = 1;
+
+    bool same = true;
+    printf("%10s %14s %14s %8s\n", "npcs", "scalar Mnpc/s", "threads Mnpc/s", "speedup");
+    for(unsigned int r = 0; r < counts.size(); r++){
+        int npcs = counts[r];
+        //about the same amount of work for every size
+        int ticks = 20000000/npcs + 1;
+
+        simulation scalar;
+        buildField(scalar, npcs);
+        double scalarRate = run(scalar, npcs, ticks);
+
+        simulation threaded;
+        buildField(threaded, npcs);
+        threaded.setThreads(threads);
+        double threadedRate = run(threaded, npcs, ticks);
+
+        bool match = scalar.stateHash() == threaded.stateHash();
+        same = same && match;
+        printf("%10d %14.2f %14.2f %7.2fx%s\n", npcs, scalarRate/1e6, threadedRate/1e6,
+               threadedRate/scalarRate, match ? "" : "  end states differ");
+    }
+    printf("%d threads, %s\n", threads, same ? "all end states match" : "END STATES DIFFER");
+    return same ? 0 : 1;
+}
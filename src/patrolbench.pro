@@ -0,0 +1,11 @@
+#times the npc patrol one at a time against the threaded one, run it with npc counts or it does 1k, 10k and 100k
+TEMPLATE = app
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(core.pri)
+
+SOURCES += \
+    patrolbench.cpp
+
+TARGET = patrolbench
@@ -0,0 +1,163 @@
+/*! \abstract replay
+ *         Records a play session so it can be played again, in the game window in real time or headless as fast as it goes.
+ *         The game rules only take random numbers from the seed and only change on a key press or a tick, so the seed, the
+ *         level and the ticked keys are all it takes to get the same game again.
+ */
+
+#include "replay.h"
+#include <fstream>
+#include <iterator>
+
+static void putVarint(std::string &out, uint64_t value){
+    while(value >= 0x80){
+        out += (char)(0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+static bool getVarint(const std::string &in, size_t &pos, uint64_t &value){
+    value = 0;
+    for(int shift = 0; shift < 64 && pos < in.size(); shift += 7){
+        unsigned char byte = in[pos++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static void putFixed(std::string &out, uint64_t value, int bytes){
+    for(int b = 0; b < bytes; b++)
+        out += (char)((value >> (8*b)) & 0xFF);
+}
+
+static bool getFixed(const std::string &in, size_t &pos, uint64_t &value, int bytes){
+    if(pos + bytes > in.size())
+        return false;
+    value = 0;
+    for(int b = 0; b < bytes; b++)
+        value |= (uint64_t)(unsigned char)in[pos++] << (8*b);
+    return true;
+}
+
+replay::replay(){
+    start(0, std::string(), 0);
+}
+
+/*! \brief replay::start
+ *  forgets the keys recorded so far and starts a new session
+ */
+void replay::start(uint32_t seed, const std::string &level, uint64_t levelHash){
+    this->seed = seed;
+    this->level = level;
+    this->levelHash = levelHash;
+    endTick = 0;
+    inputs.clear();
+}
+
+void replay::record(uint64_t tick, int key){
+    replayInput input;
+    input.tick = tick;
+    input.key = key;
+    inputs.push_back(input);
+    endTick = tick;
+}
+
+void replay::finish(uint64_t tick){
+    endTick = tick;
+}
+
+/*! \brief replay::save
+ *  magic, version, seed, level hash, end tick, level name, key count, then the keys as varints of delta*8 + key
+ */
+bool replay::save(const std::string &fileName, std::string &error) const{
+    std::string out(REPLAY_MAGIC);
+    out += (char)REPLAY_VERSION;
+    putFixed(out, seed, 4);
+    putFixed(out, levelHash, 8);
+    putVarint(out, endTick);
+    putVarint(out, level.size());
+    out += level;
+    putVarint(out, inputs.size());
+
+    uint64_t last = 0;
+    for(unsigned int i = 0; i < inputs.size(); i++){
+        putVarint(out, ((inputs[i].tick - last) << 3) | (uint64_t)inputs[i].key);
+        last = inputs[i].tick;
+    }
+
+    std::ofstream file(fileName.c_str(), std::ios::binary);
+    if(!file || !file.write(out.data(), out.size())){
+        error = fileName + ": can not write";
+        return false;
+    }
+    return true;
+}
+
+/*! \brief replay::load
+ *  reads a replay written by save, false with error set if it is not one or is cut short
+ */
+bool replay::load(const std::string &fileName, std::string &error){
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if(!file){
+        error = fileName + ": can not open";
+        return false;
+    }
+    std::string in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    size_t pos = 4;
+    uint64_t value = 0, length = 0, count = 0;
+    if(in.compare(0, 4, REPLAY_MAGIC) != 0 || in.size() < 5 || in[pos++] != REPLAY_VERSION){
+        error = fileName + ": not a replay";
+        return false;
+    }
+    start(0, std::string(), 0);
+    bool ok = getFixed(in, pos, value, 4);
+    seed = (uint32_t)value;
+    ok = ok && getFixed(in, pos, levelHash, 8) && getVarint(in, pos, endTick) && getVarint(in, pos, length);
+    ok = ok && pos + length <= in.size();
+    if(ok){
+        level = in.substr(pos, length);
+        pos += length;
+        ok = getVarint(in, pos, count);
+    }
+
+    uint64_t tick = 0;
+    for(uint64_t i = 0; ok && i < count; i++){
+        ok = getVarint(in, pos, value) && (value & 7) < REPLAY_KEYS;
+        if(ok){
+            tick += value >> 3;
+            replayInput input;
+            input.tick = tick;
+            input.key = (int)(value & 7);
+            inputs.push_back(input);
+        }
+    }
+    if(!ok){
+        error = fileName + ": replay is cut short or broken";
+        return false;
+    }
+    return true;
+}
+
+bool replay::hashFile(const std::string &fileName, uint64_t &hash){
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    if(!file)
+        return false;
+
+    hash = 0xCBF29CE484222325ULL;
+    char buffer[4096];
+    while(file.read(buffer, sizeof(buffer)) || file.gcount() > 0){
+        for(std::streamsize i = 0; i < file.gcount(); i++){
+            hash ^= (unsigned char)buffer[i];
+            hash *= 0x100000001B3ULL;
+        }
+    }
+    return true;
+}
+
+char replay::keyName(int key){
+    const char names[REPLAY_KEYS] = { 'A', 'D', ' ', 'R', 'P' };
+    return key >= 0 && key < REPLAY_KEYS ? names[key] : '?';
+}
@@ -0,0 +1,53 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define REPLAY_MAGIC "MJRP"
+#define REPLAY_VERSION ( 1 )
+
+/* the keys that change the game, escape only pauses and is left out */
+enum ReplayKey{
+    REPLAY_LEFT,      //A
+    REPLAY_RIGHT,     //D
+    REPLAY_SPACE,     //pick up, drop, open the door
+    REPLAY_RESTART,   //R
+    REPLAY_SAVE,      //P
+    REPLAY_KEYS
+};
+
+/* a key pressed after tick steps of the game loop had run */
+struct replayInput{
+    uint64_t tick;
+    int key;
+};
+
+/* one play session: the seed the game was started with, the level it started on and every key pressed.
+   On disk each key is one varint holding the ticks since the previous key and the key itself, so a key
+   is one or two bytes */
+class replay
+{
+public:
+    replay();
+
+    void start(uint32_t seed, const std::string &level, uint64_t levelHash);
+    void record(uint64_t tick, int key);
+    void finish(uint64_t tick);
+    bool save(const std::string &fileName, std::string &error) const;
+    bool load(const std::string &fileName, std::string &error);
+
+    //FNV-1a of the file's bytes, false if it can't be read
+    static bool hashFile(const std::string &fileName, uint64_t &hash);
+    static char keyName(int key);
+
+    uint32_t seed;
+    std::string level;
+    uint64_t levelHash;
+    //the tick the session ended on
+    uint64_t endTick;
+    std::vector<replayInput> inputs;
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,832 @@
+/*! \abstract simulation
+ *         The simulation holds the rules of the game as plain data: the grid of blocks that can be stood on, MJ, the good guys, the enemies
+ *         and the doors. It knows nothing about the graphics scene or the media player, so it can run headless. Every call records what changed
+ *         as a list of events and the engine mirrors those into the scene.
+ */
+
+#include "simulation.h"
+#include "workerpool.h"
+#include <algorithm>
+
+//index of the highest set bit, bits is not 0
+static int highestBit(rowBits bits){
+#if defined(__GNUC__)
+    return ROW_BITS - 1 - __builtin_clzll(bits);
+#else
+    int b = 0;
+    while(bits >>= 1)
+        b++;
+    return b;
+#endif
+}
+
+void patrolGroup::clear(){
+    x.clear();
+    y.clear();
+    dir.clear();
+    owner.clear();
+    step.clear();
+}
+
+void patrolGroup::reserve(int n){
+    x.reserve(n);
+    y.reserve(n);
+    dir.reserve(n);
+    owner.reserve(n);
+}
+
+simulation::simulation(){
+    poolThreads = 1;
+    clear();
+}
+
+/*! \brief simulation::clear
+ *  Empties the field, makes it width by height and resets mj's stats
+ */
+void simulation::clear(int width, int height){
+    kinds.clear();
+    posX.clear();
+    posY.clear();
+    holding.clear();
+    alive.clear();
+    patrolSlot.clear();
+    goodPatrol.clear();
+    enemyPatrol.clear();
+    doorIds.clear();
+    eventList.clear();
+    cellNext.clear();
+    cellPrev.clear();
+
+    fieldWidth = width < 1 ? 1 : width;
+    fieldHeight = height < 1 ? 1 : height;
+    stride = fieldWidth + 2*GRID_PAD;
+    words = (stride + ROW_BITS - 1)/ROW_BITS;
+    //the readers keep levels to LEVEL_MAX_CELLS, the sizes are worked out wide anyway
+    size_t rows = fieldHeight + 2*GRID_PAD;
+    grid.assign(rows*stride, -1);
+    actorGrid.assign(rows*stride, -1);
+    solidBits.assign(rows*words, 0);
+    walkBits.assign(rows*words, 0);
+    columnWords = (fieldHeight + ROW_BITS - 1)/ROW_BITS;
+    columnBits.assign((size_t)fieldWidth*columnWords, 0);
+    columnTop.assign(fieldWidth, -1);
+    mj = -1;
+    carrying = -1;
+    mjFacing = 0;
+    prevFacing = 0;
+    life = 3;
+    items = 0;
+    safeToCheckEnemyCollision = true;
+    contactPending = false;
+}
+
+/*! \brief simulation::reserve
+ *  makes room for n entities up front so loading a level grows every array once
+ */
+void simulation::reserve(int n){
+    kinds.reserve(n);
+    posX.reserve(n);
+    posY.reserve(n);
+    holding.reserve(n);
+    alive.reserve(n);
+    patrolSlot.reserve(n);
+    cellNext.reserve(n);
+    cellPrev.reserve(n);
+}
+
+/*! \brief simulation::addEntity
+ *  Adds a thing to the field and returns its id. Blocks are put into the grid so they can be stood on,
+ *  good guys and enemies get a slot in their patrol group
+ */
+int simulation::addEntity(EntityKind kind, int x, int y, int movement, bool hasObj){
+    int id = (int)kinds.size();
+    kinds.push_back((unsigned char)kind);
+    posX.push_back(x);
+    posY.push_back(y);
+    holding.push_back(hasObj ? 1 : 0);
+    alive.push_back(1);
+    patrolSlot.push_back(-1);
+    cellNext.push_back(-1);
+    cellPrev.push_back(-1);
+
+    //actors placed off the field are pulled onto its edge, that is as far as the padding reaches
+    if(kind == KIND_MJ || kind == KIND_GOOD || kind == KIND_ENEMY){
+        x = x < 0 ? 0 : (x >= fieldWidth ? fieldWidth - 1 : x);
+        y = y < 1 ? 1 : (y > fieldHeight + 1 ? fieldHeight + 1 : y);
+        posX[id] = x;
+        posY[id] = y;
+    }
+
+    if(kind == KIND_GOOD || kind == KIND_ENEMY){
+        patrolGroup &group = kind == KIND_GOOD ? goodPatrol : enemyPatrol;
+        patrolSlot[id] = group.size();
+        group.x.push_back(x);
+        group.y.push_back(y);
+        group.dir.push_back(movement);
+        group.owner.push_back(id);
+    }
+    else if(kind == KIND_DOOR)
+        doorIds.push_back(id);
+
+    if(kind == KIND_MJ || kind == KIND_GOOD || kind == KIND_ENEMY){
+        linkActor(id);
+        contactPending = true;
+    }
+
+    if(kind == KIND_MJ)
+        mj = id;
+    else if(kind == KIND_BLOCK || kind == KIND_MBLOCK)
+        setCell(x, y - 1, id);
+    else if(kind == KIND_GOOD && hasObj)
+        items++;
+
+    return id;
+}
+
+void simulation::setLives(int lives){
+    life = lives;
+}
+
+/*! \brief simulation::placeMJ
+ *  moves mj to x,y facing that way, carried is the block over her head or -1
+ */
+void simulation::placeMJ(int x, int y, int facing, int carried){
+    if(mj == -1)
+        return;
+
+    unlinkActor(mj);
+    posX[mj] = x;
+    posY[mj] = y;
+    linkActor(mj);
+    mjFacing = facing;
+    prevFacing = facing;
+    carrying = carried;
+    contactPending = true;
+}
+
+/*! \brief simulation::placeBlock
+ *  moves a block to x,y. Its old cell is only emptied if it still holds this block, so a set of blocks
+ *  can be placed one after another even when one takes the spot another one is leaving
+ */
+void simulation::placeBlock(int id, int x, int y){
+    if(cellAt(posX[id], posY[id] - 1) == id)
+        setCell(posX[id], posY[id] - 1, -1);
+    posX[id] = x;
+    posY[id] = y;
+    setCell(x, y - 1, id);
+}
+
+/*! \brief simulation::setThreads
+ *  how many threads the patrol may use, a pool of another size is stopped. Levels with small groups never start one
+ */
+void simulation::setThreads(int threads){
+    poolThreads = threads > 1 ? threads : 1;
+    if(pool && pool->size() != poolThreads)
+        pool.reset();
+}
+
+int simulation::threads() const{
+    return poolThreads;
+}
+
+/*! \brief simulation::stateHash
+ *  a hash of everything the rules look at, two runs that end with the same hash ended in the same state
+ */
+unsigned long long simulation::stateHash() const{
+    //FNV-1a, one int at a time
+    unsigned long long hash = 14695981039346656037ULL;
+    int n = entityCount();
+    int values[7];
+    for(int id = 0; id < n; id++){
+        Entity e = entity(id);
+        values[0] = e.kind;
+        values[1] = e.x;
+        values[2] = e.y;
+        values[3] = e.movement;
+        values[4] = e.hasObj;
+        values[5] = e.alive;
+        values[6] = cellNext[id];
+        for(int v = 0; v < 7; v++){
+            hash ^= (unsigned int)values[v];
+            hash *= 1099511628211ULL;
+        }
+    }
+    int stats[6] = { carrying, mjFacing, prevFacing, life, items, safeToCheckEnemyCollision };
+    for(int v = 0; v < 6; v++){
+        hash ^= (unsigned int)stats[v];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void simulation::clearEvents(){
+    eventList.clear();
+}
+
+/*! \brief simulation::entity
+ *  gathers the components of one entity into a copy
+ */
+Entity simulation::entity(int id) const{
+    Entity e;
+    e.kind = (EntityKind)kinds[id];
+    e.x = posX[id];
+    e.y = posY[id];
+    e.movement = 0;
+    if(patrolSlot[id] != -1)
+        e.movement = (e.kind == KIND_GOOD ? goodPatrol : enemyPatrol).dir[patrolSlot[id]];
+    e.hasObj = holding[id] != 0;
+    e.alive = alive[id] != 0;
+    return e;
+}
+
+bool simulation::isActor(int id) const{
+    return kinds[id] == KIND_MJ || kinds[id] == KIND_GOOD || kinds[id] == KIND_ENEMY;
+}
+
+/*! \brief simulation::onField
+ *  true if x,row is inside the field the level asked for
+ */
+bool simulation::onField(int x, int row) const{
+    return x >= 0 && x < fieldWidth && row >= 0 && row < fieldHeight;
+}
+
+/*! \brief simulation::cellAt
+ *  returns the id of the block in the grid cell or -1, anything off the field is empty
+ */
+int simulation::cellAt(int x, int row) const{
+    if(!onField(x, row))
+        return -1;
+    return grid[cell(x, row)];
+}
+
+/*! \brief simulation::firstActorAt
+ *  returns the first actor standing in the cell or -1, walk the rest with nextActor.
+ *  Actors can stand one row above the field, on top of the highest blocks
+ */
+int simulation::firstActorAt(int x, int row) const{
+    if(!onField(x, row) && !(row == fieldHeight && x >= 0 && x < fieldWidth))
+        return -1;
+    return actorGrid[cell(x, row)];
+}
+
+/*! \brief simulation::linkActor
+ *  puts an actor into the list of the cell it stands in, after the actors with a lower id
+ */
+void simulation::linkActor(int id){
+    int c = cell(posX[id], posY[id] - 1);
+    int prev = -1;
+    int next = actorGrid[c];
+    while(next != -1 && next < id){
+        prev = next;
+        next = cellNext[next];
+    }
+
+    cellPrev[id] = prev;
+    cellNext[id] = next;
+    if(prev != -1)
+        cellNext[prev] = id;
+    else
+        actorGrid[c] = id;
+    if(next != -1)
+        cellPrev[next] = id;
+}
+
+/*! \brief simulation::unlinkActor
+ *  takes an actor out of the list of the cell it stands in
+ */
+void simulation::unlinkActor(int id){
+    if(cellPrev[id] != -1)
+        cellNext[cellPrev[id]] = cellNext[id];
+    else
+        actorGrid[cell(posX[id], posY[id] - 1)] = cellNext[id];
+    if(cellNext[id] != -1)
+        cellPrev[cellNext[id]] = cellPrev[id];
+    cellPrev[id] = -1;
+    cellNext[id] = -1;
+}
+
+/*! \brief simulation::setCell
+ *  puts a block id (or -1) in the grid and updates the bit rows it touches,
+ *  the cell is ground for the row above and may no longer be open in its own row
+ */
+void simulation::setCell(int x, int row, int id){
+    if(!onField(x, row))
+        return;
+    grid[cell(x, row)] = id;
+
+    int w = (row + GRID_PAD)*words + (x + GRID_PAD)/ROW_BITS;
+    rowBits bit = ((rowBits)1) << ((x + GRID_PAD)%ROW_BITS);
+    if(id == -1)
+        solidBits[w] &= ~bit;
+    else
+        solidBits[w] |= bit;
+
+    walkBits[w] = solidBits[w - words] & ~solidBits[w];
+    walkBits[w + words] = solidBits[w] & ~solidBits[w + words];
+
+    rowBits &column = columnBits[x*columnWords + row/ROW_BITS];
+    rowBits rowBit = ((rowBits)1) << (row%ROW_BITS);
+    if(id == -1){
+        column &= ~rowBit;
+        if(row == columnTop[x])
+            columnTop[x] = highestBelow(x, row);
+    }
+    else{
+        column |= rowBit;
+        if(row > columnTop[x])
+            columnTop[x] = row;
+    }
+}
+
+/*! \brief simulation::highestBelow
+ *  the highest block of column x under row, or -1. Looks at a whole word of the column at a time
+ */
+int simulation::highestBelow(int x, int row) const{
+    if(row <= 0)
+        return -1;
+    if(row > columnTop[x])
+        return columnTop[x];
+
+    int r = row - 1;
+    int w = r/ROW_BITS;
+    const rowBits *column = &columnBits[x*columnWords];
+    rowBits bits = column[w];
+    if(r%ROW_BITS != ROW_BITS - 1)
+        bits &= (((rowBits)1) << (r%ROW_BITS + 1)) - 1;
+
+    while(bits == 0){
+        if(--w < 0)
+            return -1;
+        bits = column[w];
+    }
+    return w*ROW_BITS + highestBit(bits);
+}
+
+/*! \brief simulation::surfaceRow
+ *  the first empty row on top of column x, 0 if the column has no blocks
+ */
+int simulation::surfaceRow(int x) const{
+    if(x < 0 || x >= fieldWidth)
+        return 0;
+    return columnTop[x] + 1;
+}
+
+/*! \brief simulation::restingRow
+ *  where a block let go at row of column x ends up: on the highest block under it, or on row 0.
+ *  Above the top of the column that is one lookup
+ */
+int simulation::restingRow(int x, int row) const{
+    if(x < 0 || x >= fieldWidth)
+        return 0;
+    return highestBelow(x, row) + 1;
+}
+
+void simulation::moveEntity(int id, int x, int y){
+    bool actor = isActor(id);
+
+    if(actor)
+        unlinkActor(id);
+    posX[id] = x;
+    posY[id] = y;
+    if(patrolSlot[id] != -1){
+        patrolGroup &group = kinds[id] == KIND_GOOD ? goodPatrol : enemyPatrol;
+        group.x[patrolSlot[id]] = x;
+        group.y[patrolSlot[id]] = y;
+    }
+    if(actor){
+        linkActor(id);
+        //only a move into mj's cell can start a collision
+        if(id == mj || (mj != -1 && x == posX[mj] && y == posY[mj]))
+            contactPending = true;
+    }
+    post(EVENT_MOVED, id);
+}
+
+/*! \brief simulation::removePatroller
+ *  takes a good guy or enemy out of its patrol group, the last one fills the gap
+ */
+void simulation::removePatroller(int id){
+    int p = patrolSlot[id];
+    if(p == -1)
+        return;
+
+    patrolGroup &group = kinds[id] == KIND_GOOD ? goodPatrol : enemyPatrol;
+    int last = group.size() - 1;
+    group.x[p] = group.x[last];
+    group.y[p] = group.y[last];
+    group.dir[p] = group.dir[last];
+    group.owner[p] = group.owner[last];
+    patrolSlot[group.owner[p]] = p;
+
+    group.x.pop_back();
+    group.y.pop_back();
+    group.dir.pop_back();
+    group.owner.pop_back();
+    patrolSlot[id] = -1;
+}
+
+void simulation::post(SimEventType type, int id){
+    SimEvent e;
+    e.type = type;
+    e.id = id;
+    eventList.push_back(e);
+}
+
+/*! \brief simulation::moveChar
+ *  Turns mj, or steps her left or right if she already faces that way. She can step up one block,
+ *  step down one block or walk on flat ground, and the block she carries comes along with her
+ */
+void simulation::moveChar(int direction){
+    if(mj == -1)
+        return;
+
+    if(mjFacing == -direction || mjFacing == 0)
+        mjFacing = mjFacing + direction;
+
+    if(direction != 0 && prevFacing == mjFacing){
+        int x = posX[mj];
+        int y = posY[mj];
+        int row = y - 1;
+        int nx = x + direction;
+        int dy = 0;
+        bool move = false;
+
+        //going down
+        if(!solid(nx, row) && !solid(nx, row - 1) && solid(nx, row - 2)){
+            dy = -1;
+            move = true;
+        }
+        //going up, the block she carries needs room too, on the field where it can still be stood on
+        else if(solid(nx, row) && !solid(nx, row + 1)){
+            if(carrying == -1 || (onField(nx, row + 2) && !solid(nx, row + 2))){
+                dy = 1;
+                move = true;
+            }
+        }
+        //flat ground
+        else if(solid(nx, row - 1) && !solid(nx, row)){
+            if(carrying == -1 || !solid(nx, row + 1))
+                move = true;
+        }
+
+        if(move){
+            moveEntity(mj, nx, y + dy);
+            if(carrying != -1){
+                setCell(x, row + 1, -1);
+                setCell(nx, row + 1 + dy, carrying);
+                moveEntity(carrying, nx, y + dy + 1);
+            }
+        }
+    }
+
+    prevFacing = mjFacing;
+    safeToCheckEnemyCollision = true;
+    //turning around counts, an enemy in her cell hits her again
+    contactPending = true;
+}
+
+/*! \brief simulation::getBlock
+ *  mj picks up the MBLOCK she is facing, or the one under her when she faces front
+ */
+bool simulation::getBlock(){
+    if(mj == -1 || carrying != -1)
+        return false;
+
+    int mx = posX[mj];
+    int my = posY[mj];
+    int x = mx + mjFacing;
+    int row = my - 1;
+    if(mjFacing == 0)
+        row = row - 1;
+
+    int id = cellAt(x, row);
+    if(id == -1 || kinds[id] != KIND_MBLOCK)
+        return false;
+
+    if(mjFacing == 0){
+        //swap places with the block below her
+        setCell(x, row, -1);
+        moveEntity(mj, mx, my - 1);
+        setCell(x, row + 1, id);
+        moveEntity(id, x, row + 2);
+    }
+    else{
+        //lift it over her head
+        if(my >= fieldHeight || solid(mx, my))
+            return false;
+        setCell(x, row, -1);
+        setCell(mx, my, id);
+        moveEntity(id, mx, my + 1);
+    }
+    carrying = id;
+    return true;
+}
+
+/*! \brief simulation::dropBlock
+ *  puts the carried block down in front of mj, lets it fall and squishes any enemy it lands on
+ */
+bool simulation::dropBlock(){
+    if(mj == -1 || carrying == -1 || mjFacing == 0)
+        return false;
+
+    int x = posX[mj] + mjFacing;
+    int row = posY[mj];
+    if(x < 0 || x >= fieldWidth || solid(x, row))
+        return false;
+
+    int id = carrying;
+    setCell(posX[mj], row, -1);
+    carrying = -1;
+
+    //let go of it in front of her
+    posX[id] = x;
+    posY[id] = row + 1;
+    dropped.assign(1, id);
+    settleBlocks(dropped);
+    return true;
+}
+
+/*! \brief simulation::settleBlocks
+ *  lets go of every block in ids at once. Each falls straight down onto the column's highest block under it
+ *  and squishes any enemy where it lands. The blocks are sorted bottom up per column so one landing on another
+ *  just stacks, and each one only costs a lookup in the column index
+ */
+void simulation::settleBlocks(std::vector<int> &ids){
+    //they are all in the air before any of them lands
+    for(unsigned int i = 0; i < ids.size(); i++){
+        int id = ids[i];
+        if(cellAt(posX[id], posY[id] - 1) == id)
+            setCell(posX[id], posY[id] - 1, -1);
+    }
+
+    const std::vector<int> &x = posX;
+    const std::vector<int> &y = posY;
+    std::sort(ids.begin(), ids.end(), [&x, &y](int a, int b){
+        if(x[a] != x[b])
+            return x[a] < x[b];
+        if(y[a] != y[b])
+            return y[a] < y[b];
+        return a < b;
+    });
+
+    for(unsigned int i = 0; i < ids.size(); i++){
+        int id = ids[i];
+        int row = restingRow(posX[id], posY[id] - 1);
+        setCell(posX[id], row, id);
+        moveEntity(id, posX[id], row + 1);
+        crushAt(posX[id], row);
+    }
+}
+
+/*! \brief simulation::crushAt
+ *  a block landed in the cell, any enemy there is squished
+ */
+void simulation::crushAt(int x, int row){
+    int i = firstActorAt(x, row);
+    while(i != -1){
+        int next = cellNext[i];
+        if(kinds[i] == KIND_ENEMY){
+            alive[i] = 0;
+            unlinkActor(i);
+            removePatroller(i);
+            post(EVENT_CRUSHED, i);
+        }
+        i = next;
+    }
+}
+
+/*! \brief simulation::patrol
+ *  walks every good guy or enemy in the group one block along its platform, turning around at the edge
+ */
+void simulation::patrol(patrolGroup &group, bool isEnemy){
+    if(poolThreads > 1 && group.size() >= PARALLEL_PATROL_MIN)
+        patrolParallel(group, isEnemy);
+    else
+        patrolScalar(group, isEnemy);
+
+    //an enemy walking anywhere lets one that stands in mj's cell hit her again, so that is checked too
+    if(isEnemy && safeToCheckEnemyCollision && mj != -1)
+        contactPending = true;
+}
+
+/*! \brief simulation::patrolScalar
+ *  the patrol one npc at a time, patrolParallel has to come out the same
+ */
+void simulation::patrolScalar(patrolGroup &group, bool isEnemy){
+    int n = group.size();
+    for(int p = 0; p < n; p++){
+        int dir = group.dir[p];
+        if(dir != 0 && dir != 1)
+            continue;
+
+        int x = group.x[p];
+        int row = group.y[p] - 1;
+        int step = dir == 0 ? -1 : 1;
+
+        if(rowBit(standableRow(row), x + step)){
+            moveEntity(group.owner[p], x + step, group.y[p]);
+            if(isEnemy)
+                safeToCheckEnemyCollision = true;
+        }
+        //at edge, turn around
+        else if(solid(x - step, row - 1)){
+            group.dir[p] = 1 - dir;
+        }
+    }
+}
+
+/*! \brief simulation::decidePatrol
+ *  works out step and dir for the slots begin .. end-1 of the group. Walking around never changes the blocks,
+ *  so every npc can decide at once. There are no branches and it only reads the bit rows, so the compiler can vectorize it
+ */
+void simulation::decidePatrol(patrolGroup &group, int begin, int end){
+    const int *x = group.x.data();
+    const int *y = group.y.data();
+    int *dir = group.dir.data();
+    int *step = group.step.data();
+    const rowBits *walk = walkBits.data();
+    const rowBits *ground = solidBits.data();
+    const int w = words;
+
+    for(int p = begin; p < end; p++){
+        int d = dir[p];
+        //anything but 0 or 1 stands still, d & 1 keeps the reads in the grid either way
+        int valid = (unsigned int)d <= 1;
+        int s = 2*(d & 1) - 1;
+        int row = (y[p] - 1 + GRID_PAD)*w;
+        unsigned int ahead = x[p] + GRID_PAD + s;
+        unsigned int behind = x[p] + GRID_PAD - s;
+
+        int go = valid & (int)(walk[row + ahead/ROW_BITS] >> (ahead%ROW_BITS)) & 1;
+        int edge = valid & (go ^ 1) & (int)(ground[row - w + behind/ROW_BITS] >> (behind%ROW_BITS)) & 1;
+
+        step[p] = go*s;
+        dir[p] = d ^ edge;
+    }
+}
+
+/*! \brief simulation::stepPatroller
+ *  moveEntity for the npc in slot p, without looking up what it is or where its slot is
+ */
+void simulation::stepPatroller(patrolGroup &group, int p){
+    int id = group.owner[p];
+    unlinkActor(id);
+    int nx = group.x[p] + group.step[p];
+    group.x[p] = nx;
+    posX[id] = nx;
+    linkActor(id);
+}
+
+/*! \brief simulation::patrolParallel
+ *  the patrol split over the pool. The slots are cut into chunks that decide on their own, each chunk sorts its
+ *  walkers by the column band they stay in. Then every band moves its walkers, a cell belongs to one band so no
+ *  two jobs touch the same list. The few that cross into another band are moved last, one at a time in slot order.
+ *  Cell lists are sorted by id and the events are written in slot order, so the result is the same as patrolScalar
+ */
+void simulation::patrolParallel(patrolGroup &group, bool isEnemy){
+    if(!pool)
+        pool = std::make_shared<workerPool>(poolThreads);
+    int n = group.size();
+    group.step.resize(n);
+
+    int threads = pool->size();
+    int chunks = threads*4;
+    int bands = threads*4 < fieldWidth ? threads*4 : fieldWidth;
+    bandMovers.resize(chunks*bands);
+    crossMovers.resize(chunks);
+    chunkMoved.assign(chunks, 0);
+    chunkContact.assign(chunks, 0);
+    int mjCell = mj == -1 ? -1 : cell(posX[mj], posY[mj] - 1);
+
+    pool->run(chunks, [&](int c){
+        int begin = (int)((long long)n*c/chunks);
+        int end = (int)((long long)n*(c + 1)/chunks);
+        decidePatrol(group, begin, end);
+
+        for(int b = 0; b < bands; b++)
+            bandMovers[c*bands + b].clear();
+        crossMovers[c].clear();
+        for(int p = begin; p < end; p++){
+            if(group.step[p] == 0)
+                continue;
+
+            int x = group.x[p];
+            int nx = x + group.step[p];
+            int band = (int)((long long)x*bands/fieldWidth);
+            if(band == (int)((long long)nx*bands/fieldWidth))
+                bandMovers[c*bands + band].push_back(p);
+            else
+                crossMovers[c].push_back(p);
+            if(cell(nx, group.y[p] - 1) == mjCell)
+                chunkContact[c] = 1;
+            chunkMoved[c]++;
+        }
+    });
+
+    //each chunk writes its events after the ones of the chunks before it
+    int base = (int)eventList.size();
+    int total = 0;
+    for(int c = 0; c < chunks; c++){
+        int moved = chunkMoved[c];
+        chunkMoved[c] = base + total;
+        total += moved;
+        if(chunkContact[c])
+            contactPending = true;
+    }
+    eventList.resize(base + total);
+
+    pool->run(chunks + bands, [&](int j){
+        if(j < chunks){
+            int begin = (int)((long long)n*j/chunks);
+            int end = (int)((long long)n*(j + 1)/chunks);
+            int e = chunkMoved[j];
+            for(int p = begin; p < end; p++){
+                if(group.step[p] != 0){
+                    eventList[e].type = EVENT_MOVED;
+                    eventList[e].id = group.owner[p];
+                    e++;
+                }
+            }
+        }
+        else{
+            int band = j - chunks;
+            for(int c = 0; c < chunks; c++){
+                const std::vector<int> &movers = bandMovers[c*bands + band];
+                for(unsigned int m = 0; m < movers.size(); m++)
+                    stepPatroller(group, movers[m]);
+            }
+        }
+    });
+
+    for(int c = 0; c < chunks; c++){
+        for(unsigned int m = 0; m < crossMovers[c].size(); m++)
+            stepPatroller(group, crossMovers[c][m]);
+    }
+
+    if(isEnemy && total > 0)
+        safeToCheckEnemyCollision = true;
+}
+
+/*! \brief simulation::moveGood
+ * moves the good characters
+ */
+void simulation::moveGood(){
+    patrol(goodPatrol, false);
+}
+
+/*! \brief simulation::moveEnemies
+ * moves the enemies
+ */
+void simulation::moveEnemies(){
+    patrol(enemyPatrol, true);
+}
+
+/*! \brief simulation::checkCollisions
+ *  mj takes the item from a good guy she walks into and loses a life to an enemy she walks into
+ */
+void simulation::checkCollisions(){
+    if(mj == -1 || !contactPending)
+        return;
+    contactPending = false;
+
+    for(int i = firstActorAt(posX[mj], posY[mj] - 1); i != -1; i = cellNext[i]){
+        if(kinds[i] == KIND_GOOD && holding[i]){
+            holding[i] = 0;
+            items--;
+            post(EVENT_ITEM, i);
+        }
+        else if(kinds[i] == KIND_ENEMY && safeToCheckEnemyCollision){
+            life--;
+            safeToCheckEnemyCollision = false;
+            post(EVENT_HURT, i);
+            if(life <= 0){
+                post(EVENT_DIED, i);
+                return;
+            }
+        }
+    }
+}
+
+/*! \brief simulation::tick
+ *  one step of the game without any input: npcs walk, then collisions are checked
+ */
+void simulation::tick(){
+    moveEnemies();
+    moveGood();
+    checkCollisions();
+}
+
+/*! \brief simulation::mjAtDoor
+ *  true if mj is standing in front of a door
+ */
+bool simulation::mjAtDoor() const{
+    if(mj == -1)
+        return false;
+
+    for(unsigned int i = 0; i < doorIds.size(); i++){
+        int d = doorIds[i];
+        if(posX[d] == posX[mj] && posY[d] == posY[mj])
+            return true;
+    }
+    return false;
+}
@@ -0,0 +1,208 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <vector>
+#include <memory>
+#include <stdint.h>
+
+class workerPool;
+
+//the field size when a level does not say
+#define GRID_WIDTH ( 30 )
+#define GRID_HEIGHT ( 20 )
+//empty cells kept around the field so looking at a neighbour never needs a bounds check,
+//the rules look at most 2 rows and 1 column away from an actor that can itself be 1 row above the field
+#define GRID_PAD ( 3 )
+#define ROW_BITS ( 64 )
+//patrol groups smaller than PARALLEL_PATROL_MIN are not worth splitting over threads
+#define PARALLEL_PATROL_MIN ( 4096 )
+//the game loop runs fixed steps of TICK_MS, npcs walk every NPC_TICKS steps
+#define TICK_MS ( 20 )
+#define NPC_TICKS ( 25 )
+
+/* one bit per cell, bit x + GRID_PAD of a row is set when column x holds a block */
+typedef uint64_t rowBits;
+
+/* the kinds of things the game rules care about, scenery is left to the engine */
+enum EntityKind{
+    KIND_MJ,
+    KIND_GOOD,
+    KIND_ENEMY,
+    KIND_BLOCK,
+    KIND_MBLOCK,
+    KIND_DOOR
+};
+
+/* things that happened during the last call, the engine mirrors these into the scene */
+enum SimEventType{
+    EVENT_MOVED,     //entity x,y changed
+    EVENT_ITEM,      //mj took the item a good guy was holding
+    EVENT_CRUSHED,   //an enemy got squished by a dropped block
+    EVENT_HURT,      //mj walked into an enemy and lost a life
+    EVENT_DIED       //mj is out of lives, the level has to be restarted
+};
+
+struct SimEvent{
+    SimEventType type;
+    int id;
+};
+
+/* a copy of one thing on the field, x and y use the level file coordinates */
+struct Entity{
+    EntityKind kind;
+    int x;
+    int y;
+    int movement;
+    bool hasObj;
+    bool alive;
+};
+
+/* good guys or enemies packed together so a patrol step is one pass over plain arrays,
+   slot p belongs to entity owner[p] */
+struct patrolGroup{
+    std::vector<int> x;
+    std::vector<int> y;
+    std::vector<int> dir;
+    std::vector<int> owner;
+    //scratch for the threaded patrol, how far each one walks this step
+    std::vector<int> step;
+
+    int size() const { return (int)owner.size(); }
+    void clear();
+    void reserve(int n);
+};
+
+class simulation
+{
+public:
+    simulation();
+
+    void clear(int width = GRID_WIDTH, int height = GRID_HEIGHT);
+    void reserve(int n);
+    int addEntity(EntityKind kind, int x, int y, int movement = 0, bool hasObj = false);
+    void setLives(int lives);
+    //put mj or a block straight into a spot without any rules or events, the solver uses these to jump between states
+    void placeMJ(int x, int y, int facing, int carried);
+    void placeBlock(int id, int x, int y);
+
+    void moveChar(int direction);
+    bool getBlock();
+    bool dropBlock();
+    void settleBlocks(std::vector<int> &ids);
+    void moveEnemies();
+    void moveGood();
+    void checkCollisions();
+    void tick();
+    bool mjAtDoor() const;
+    //big patrol groups are split into column bands over this many threads, 1 runs everything on the caller.
+    //the threads are only started once a group is big enough to be split
+    void setThreads(int threads);
+    int threads() const;
+    unsigned long long stateHash() const;
+
+    void clearEvents();
+    const std::vector<SimEvent>& events() const { return eventList; }
+    Entity entity(int id) const;
+    int entityCount() const { return (int)kinds.size(); }
+    int cellAt(int x, int row) const;
+    int firstActorAt(int x, int row) const;
+    int nextActor(int id) const { return cellNext[id]; }
+    int width() const { return fieldWidth; }
+    int height() const { return fieldHeight; }
+
+    //a row is rowWords() words, use rowBit to read column x out of it
+    int rowWords() const { return words; }
+    const rowBits* solidRow(int row) const { return &solidBits[(row + GRID_PAD)*words]; }
+    const rowBits* standableRow(int row) const { return &walkBits[(row + GRID_PAD)*words]; }
+    static bool rowBit(const rowBits *bits, int x) { return (bits[(x + GRID_PAD)/ROW_BITS] >> ((x + GRID_PAD)%ROW_BITS)) & 1; }
+    int surfaceRow(int x) const;
+    int restingRow(int x, int row) const;
+
+    int mjId() const { return mj; }
+    int carriedBlock() const { return carrying; }
+    int facing() const { return mjFacing; }
+    bool mjHasBlock() const { return carrying != -1; }
+    int lives() const { return life; }
+    int itemCount() const { return items; }
+    //something moved into mj's cell or she moved or turned, checkCollisions has work to do
+    bool collisionPending() const { return mj != -1 && contactPending; }
+
+private:
+    //components, indexed by entity id. ids stay the same until clear()
+    std::vector<unsigned char> kinds;
+    std::vector<int> posX;
+    std::vector<int> posY;
+    std::vector<unsigned char> holding;
+    std::vector<unsigned char> alive;
+    std::vector<int> patrolSlot;
+
+    patrolGroup goodPatrol;
+    patrolGroup enemyPatrol;
+    std::vector<int> doorIds;
+
+    std::vector<SimEvent> eventList;
+
+    //the field with GRID_PAD empty cells on every side, cell() gives the index of x,row
+    int fieldWidth;
+    int fieldHeight;
+    int stride;
+    int words;
+
+    //ids of the blocks that can be stood on, row 0 is level y 1
+    std::vector<int> grid;
+    //the same grid packed into bits, kept in sync by setCell. walkBits is where an npc can stand
+    std::vector<rowBits> solidBits;
+    std::vector<rowBits> walkBits;
+
+    //the grid again one column at a time, bit row of column x is set when it holds a block, and the
+    //highest block of every column (-1 when it has none). Kept up to date by setCell like the bit rows
+    int columnWords;
+    std::vector<rowBits> columnBits;
+    std::vector<int> columnTop;
+
+    //which actors (mj, good guys, enemies) stand in each cell, kept as a linked list through cellNext/cellPrev
+    //and updated on every move. A list is sorted by id, so it comes out the same whatever order the moves are made in
+    std::vector<int> actorGrid;
+    std::vector<int> cellNext;
+    std::vector<int> cellPrev;
+
+    int mj;
+    int carrying;
+    int mjFacing;
+    int prevFacing;
+    int life;
+    int items;
+    bool safeToCheckEnemyCollision;
+
+    //threads for the patrol and what each job of patrolParallel collects, kept so they are not allocated every step.
+    //the pool is made by the first patrolParallel, with poolThreads threads
+    int poolThreads;
+    std::shared_ptr<workerPool> pool;
+    std::vector<std::vector<int> > bandMovers;
+    std::vector<std::vector<int> > crossMovers;
+    std::vector<int> chunkMoved;
+    std::vector<int> dropped;
+    std::vector<unsigned char> chunkContact;
+    //something moved into mj's cell, or mj moved, since the last collision check
+    bool contactPending;
+
+    bool isActor(int id) const;
+    bool onField(int x, int row) const;
+    int cell(int x, int row) const { return (row + GRID_PAD)*stride + x + GRID_PAD; }
+    bool solid(int x, int row) const { return rowBit(solidRow(row), x); }
+    void setCell(int x, int row, int id);
+    int highestBelow(int x, int row) const;
+    void crushAt(int x, int row);
+    void moveEntity(int id, int x, int y);
+    void linkActor(int id);
+    void unlinkActor(int id);
+    void removePatroller(int id);
+    void post(SimEventType type, int id);
+    void patrol(patrolGroup &group, bool isEnemy);
+    void patrolScalar(patrolGroup &group, bool isEnemy);
+    void patrolParallel(patrolGroup &group, bool isEnemy);
+    void decidePatrol(patrolGroup &group, int begin, int end);
+    void stepPatroller(patrolGroup &group, int p);
+};
+
+#endif // SIMULATION_H
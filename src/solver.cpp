@@ -0,0 +1,459 @@
+/*! \abstract levelSolver
+ *         Finds out if a level can be beaten and the fewest key presses that do it. It searches breadth first, one layer of
+ *         states at a time. A layer is cut into chunks that are expanded on the worker pool, each with its own simulation,
+ *         so the real game rules decide every move. The chunks are merged in order, so the answer does not depend on the
+ *         number of threads.
+ *
+ *         A state is a few words: mj's cell, her facing and whether she carries a block, the items she has and the sorted
+ *         cells of the movable blocks (they all act the same, so which one is where does not matter). States are told apart
+ *         by a Zobrist hash, and the visited set only keeps the hashes in a table of fixed size. Only the layer being expanded
+ *         is kept packed, for the ones before it the parent and the key are enough to rebuild the way. When the memory runs
+ *         out the search stops and the level is reported unknown.
+ */
+
+#include "solver.h"
+#include "workerpool.h"
+#include "gamerandom.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#define SOLVER_ACTIONS ( 3 )
+//how many lookups ahead of the visited table to prefetch
+#define SOLVER_PREFETCH ( 8 )
+static const char actionKeys[SOLVER_ACTIONS] = { 'A', 'D', 'S' };
+
+//splitmix64, the Zobrist keys come from a fixed seed so hashes are the same on every run
+static uint64_t nextKey(uint64_t &seed){
+    uint64_t z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+levelSolver::levelSolver(const levelFile &level, int threads, long long memoryBytes) :
+    level(level), threads(threads < 1 ? 1 : threads), memoryBytes(memoryBytes)
+{
+    width = level.width;
+    //mj can stand one row above the field and y starts at 1
+    cells = level.width*(level.height + 2);
+
+    for(unsigned int i = 0; i < level.entries.size(); i++){
+        const levelEntry &e = level.entries[i];
+        npc n;
+        n.x = e.x;
+        n.y = e.y;
+        n.item = -1;
+        if(e.keyword == LEVEL_GOOD){
+            if(e.hasObj)
+                n.item = (int)goods.size();
+            goods.push_back(n);
+        }
+        else if(e.keyword == LEVEL_ENEMY)
+            enemies.push_back(n);
+    }
+
+    //good guys without an item are kept so the numbering stays simple, they just never hand anything over
+    itemWords = ((int)goods.size() + 31)/32;
+    if(itemWords > 8)
+        itemWords = 8;
+    for(int w = 0; w < 8; w++)
+        allItems[w] = 0;
+    for(unsigned int g = 0; g < goods.size(); g++){
+        if(goods[g].item != -1 && goods[g].item < 256)
+            allItems[goods[g].item/32] |= 1u << (goods[g].item%32);
+        else
+            goods[g].item = -1;
+    }
+}
+
+/*! \brief levelSolver::encode
+ *  packs the simulation's state and the item mask into stride words
+ */
+void levelSolver::encode(const simulation &sim, const uint32_t *items, uint32_t *out) const{
+    Entity m = sim.entity(sim.mjId());
+    out[0] = cellOf(m.x, m.y);
+    out[1] = (sim.facing() + 1) | (sim.mjHasBlock() ? 4 : 0);
+    for(int w = 0; w < itemWords; w++)
+        out[2 + w] = items[w];
+
+    uint32_t *blocks = out + 2 + itemWords;
+    for(unsigned int b = 0; b < blockIds.size(); b++){
+        Entity e = sim.entity(blockIds[b]);
+        blocks[b] = cellOf(e.x, e.y);
+    }
+    std::sort(blocks, blocks + blockIds.size());
+}
+
+/*! \brief levelSolver::decode
+ *  puts a packed state into a simulation
+ */
+void levelSolver::decode(simulation &sim, const uint32_t *state) const{
+    const uint32_t *blocks = state + 2 + itemWords;
+    int carried = -1;
+    for(unsigned int b = 0; b < blockIds.size(); b++){
+        //most keys leave the blocks alone, those need not be touched
+        Entity e = sim.entity(blockIds[b]);
+        if((uint32_t)cellOf(e.x, e.y) != blocks[b])
+            sim.placeBlock(blockIds[b], blocks[b] % width, blocks[b] / width);
+        if((state[1] & 4) && blocks[b] == state[0] + width)
+            carried = blockIds[b];
+    }
+    sim.placeMJ(state[0] % width, state[0] / width, (int)(state[1] & 3) - 1, carried);
+}
+
+/*! \brief levelSolver::hash
+ *  Zobrist hash, one key per thing that is true about the state xor'ed together
+ */
+uint64_t levelSolver::hash(const uint32_t *state) const{
+    uint64_t h = zobristMJ[state[0]] ^ zobristFlags[state[1]];
+    for(int w = 0; w < itemWords; w++){
+        uint32_t bits = state[2 + w];
+        for(int b = 0; bits != 0; b++, bits >>= 1){
+            if(bits & 1)
+                h ^= zobristItem[w*32 + b];
+        }
+    }
+    const uint32_t *blocks = state + 2 + itemWords;
+    for(unsigned int b = 0; b < blockIds.size(); b++)
+        h ^= zobristBlock[blocks[b]];
+    //0 marks an empty slot in the visited table
+    return h == 0 ? 1 : h;
+}
+
+/*! \brief levelSolver::onRun
+ *  true if mj stands on the stretch of floor an npc walks back and forth on
+ */
+bool levelSolver::onRun(const simulation &sim, const npc &n) const{
+    Entity m = sim.entity(sim.mjId());
+    if(m.y != n.y)
+        return false;
+    if(m.x == n.x)
+        return true;
+
+    const rowBits *walk = sim.standableRow(n.y - 1);
+    int from = m.x < n.x ? m.x : n.x;
+    int to = m.x < n.x ? n.x : m.x;
+    for(int x = from; x <= to; x++){
+        if(!simulation::rowBit(walk, x))
+            return false;
+    }
+    return true;
+}
+
+void levelSolver::collect(const simulation &sim, uint32_t *items) const{
+    for(unsigned int g = 0; g < goods.size(); g++){
+        int item = goods[g].item;
+        if(item != -1 && !(items[item/32] & (1u << (item%32))) && onRun(sim, goods[g]))
+            items[item/32] |= 1u << (item%32);
+    }
+}
+
+bool levelSolver::hasAll(const uint32_t *items) const{
+    for(int w = 0; w < itemWords; w++){
+        if(items[w] != allItems[w])
+            return false;
+    }
+    return true;
+}
+
+/*! \brief levelSolver::apply
+ *  one key press, the same calls the game window makes
+ */
+void levelSolver::apply(simulation &sim, char action){
+    if(action == 'A')
+        sim.moveChar(-1);
+    else if(action == 'D')
+        sim.moveChar(1);
+    else if(sim.mjHasBlock())
+        sim.dropBlock();
+    else
+        sim.getBlock();
+    sim.clearEvents();
+}
+
+/*! \brief levelSolver::goal
+ *  space was just pressed: the level is done if every item is in and mj is at a door
+ */
+bool levelSolver::goal(const simulation &sim, const uint32_t *items) const{
+    return hasAll(items) && sim.mjAtDoor();
+}
+
+/*! \brief levelSolver::expand
+ *  tries every key on the states begin .. end-1, keeps the new states that were not seen in an earlier layer
+ */
+void levelSolver::expand(int chunk, int begin, int end, chunkOut &out){
+    simulation &sim = *sims[chunk];
+    std::vector<uint32_t> next(stride);
+    uint32_t items[8];
+
+    out.states.clear();
+    out.hashes.clear();
+    out.parents.clear();
+    out.actions.clear();
+    out.goalParent = -1;
+
+    for(int s = begin; s < end; s++){
+        const uint32_t *state = &layer[(size_t)(s - layerStart)*stride];
+        for(int a = 0; a < SOLVER_ACTIONS; a++){
+            decode(sim, state);
+            for(int w = 0; w < itemWords; w++)
+                items[w] = state[2 + w];
+
+            apply(sim, actionKeys[a]);
+            collect(sim, items);
+            if(actionKeys[a] == 'S' && goal(sim, items)){
+                out.goalParent = s;
+                out.goalAction = a;
+                return;
+            }
+
+            encode(sim, items, next.data());
+            out.states.insert(out.states.end(), next.begin(), next.end());
+            out.hashes.push_back(hash(next.data()));
+            out.parents.push_back(s);
+            out.actions.push_back(a);
+        }
+    }
+
+    //the visited table is far bigger than the cache, so the lookups go in a second pass that asks for the
+    //slots a few states ahead before they are needed
+    unsigned int kept = 0;
+    for(unsigned int i = 0; i < out.hashes.size(); i++){
+#ifdef __GNUC__
+        if(i + SOLVER_PREFETCH < out.hashes.size())
+            __builtin_prefetch(&visited[out.hashes[i + SOLVER_PREFETCH] & visitedMask]);
+#endif
+        if(seen(out.hashes[i]))
+            continue;
+        if(kept != i){
+            std::copy(out.states.begin() + (size_t)i*stride, out.states.begin() + (size_t)(i + 1)*stride,
+                      out.states.begin() + (size_t)kept*stride);
+            out.hashes[kept] = out.hashes[i];
+            out.parents[kept] = out.parents[i];
+            out.actions[kept] = out.actions[i];
+        }
+        kept++;
+    }
+    out.states.resize((size_t)kept*stride);
+    out.hashes.resize(kept);
+    out.parents.resize(kept);
+    out.actions.resize(kept);
+}
+
+bool levelSolver::seen(uint64_t h) const{
+    for(uint64_t i = h & visitedMask; ; i = (i + 1) & visitedMask){
+        if(visited[i] == h)
+            return true;
+        if(visited[i] == 0)
+            return false;
+    }
+}
+
+/*! \brief levelSolver::visit
+ *  adds a hash to the visited set, false if it was already there
+ */
+bool levelSolver::visit(uint64_t h){
+    //doubles while it is allowed to, so small levels do not pay for clearing the whole budget
+    if((visitedCount + 1)*2 > (long long)visited.size() && (long long)visited.size() < visitedLimit){
+        std::vector<uint64_t> old(visited.size()*2, 0);
+        old.swap(visited);
+        visitedMask = visited.size() - 1;
+        for(unsigned int o = 0; o < old.size(); o++){
+            if(old[o] == 0)
+                continue;
+            uint64_t i = old[o] & visitedMask;
+            while(visited[i] != 0)
+                i = (i + 1) & visitedMask;
+            visited[i] = old[o];
+        }
+    }
+    for(uint64_t i = h & visitedMask; ; i = (i + 1) & visitedMask){
+        if(visited[i] == h)
+            return false;
+        if(visited[i] == 0){
+            visited[i] = h;
+            visitedCount++;
+            return true;
+        }
+    }
+}
+
+/*! \brief levelSolver::solve
+ *  runs the search and fills in the result
+ */
+solverResult levelSolver::solve(){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    solverResult result;
+    result.status = SOLVER_UNKNOWN;
+    result.states = 0;
+    result.blockMoves = 0;
+    result.exposure = 0;
+    result.difficulty = 0;
+    result.seconds = 0;
+
+    if(cells <= 0 || cells > SOLVER_MAX_CELLS){
+        result.note = "level too big to search";
+        return result;
+    }
+
+    //no npcs, so nothing is drawn from random
+    gameRandom random;
+    int chunks = threads*4;
+    for(int c = 0; c < chunks; c++){
+        sims.push_back(new simulation());
+        level.addTo(*sims.back(), false, random);
+    }
+    simulation &first = *sims[0];
+    if(first.mjId() == -1)
+        result.note = "no MJ";
+    else{
+        for(int id = 0; id < first.entityCount(); id++){
+            if(first.entity(id).kind == KIND_MBLOCK)
+                blockIds.push_back(id);
+        }
+        //states keep mj and the movable blocks as cells of the field, one off it has no cell
+        if(!inCells(first.entity(first.mjId())))
+            result.note = "MJ off the field";
+        for(unsigned int b = 0; b < blockIds.size() && result.note.empty(); b++){
+            if(!inCells(first.entity(blockIds[b])))
+                result.note = "movable block off the field";
+        }
+    }
+    if(!result.note.empty()){
+        for(int c = 0; c < chunks; c++)
+            delete sims[c];
+        sims.clear();
+        blockIds.clear();
+        return result;
+    }
+    stride = 2 + itemWords + (int)blockIds.size();
+
+    uint64_t seed = 0x5EEDull;
+    zobristMJ.resize(cells);
+    zobristBlock.resize(cells);
+    for(int c = 0; c < cells; c++){
+        zobristMJ[c] = nextKey(seed);
+        zobristBlock[c] = nextKey(seed);
+    }
+    for(int f = 0; f < 8; f++)
+        zobristFlags[f] = nextKey(seed);
+    zobristItem.resize(itemWords*32);
+    for(unsigned int i = 0; i < zobristItem.size(); i++)
+        zobristItem[i] = nextKey(seed);
+
+    //a state costs two slots of the visited table (it is kept at most half full), its parent and key, and while its
+    //layer is current its packed words. The widest layer is guessed at a quarter of all states
+    long long perState = 8*2 + 4 + 1 + (long long)stride*4/4;
+    long long maxStates = memoryBytes/perState;
+    visitedLimit = 1024;
+    while(visitedLimit < maxStates*2)
+        visitedLimit *= 2;
+    visited.assign(1024, 0);
+    visitedMask = visited.size() - 1;
+    visitedCount = 0;
+
+    //the start, mj may already stand next to a good guy
+    uint32_t items[8] = { 0 };
+    collect(first, items);
+    layer.resize(stride);
+    layerStart = 0;
+    encode(first, items, layer.data());
+    parents.push_back(0);
+    actions.push_back(0);
+    visit(hash(layer.data()));
+
+    workerPool pool(threads);
+    std::vector<chunkOut> outs(chunks);
+    int goalParent = -1;
+    int goalAction = 0;
+    bool full = false;
+
+    int begin = 0;
+    int end = 1;
+    while(begin < end && goalParent == -1 && !full){
+        int count = end - begin;
+        int jobs = count < chunks ? count : chunks;
+        pool.run(jobs, [&](int c){
+            expand(c, begin + (int)((long long)count*c/jobs), begin + (int)((long long)count*(c + 1)/jobs), outs[c]);
+        });
+
+        //in chunk order, so the same state is kept whatever thread found it first
+        nextLayer.clear();
+        for(int c = 0; c < jobs && goalParent == -1 && !full; c++){
+            chunkOut &out = outs[c];
+            for(unsigned int i = 0; i < out.hashes.size(); i++){
+                if(!visit(out.hashes[i]))
+                    continue;
+                nextLayer.insert(nextLayer.end(), out.states.begin() + i*stride, out.states.begin() + (i + 1)*stride);
+                parents.push_back(out.parents[i]);
+                actions.push_back(out.actions[i]);
+                if((long long)parents.size() >= maxStates){
+                    full = true;
+                    break;
+                }
+            }
+            if(out.goalParent != -1){
+                goalParent = out.goalParent;
+                goalAction = out.goalAction;
+            }
+        }
+
+        layer.swap(nextLayer);
+        layerStart = end;
+        begin = end;
+        end = (int)parents.size();
+    }
+
+    result.states = (long long)parents.size();
+    if(goalParent != -1){
+        result.status = SOLVER_SOLVED;
+        result.inputs = actionKeys[goalAction];
+        for(int s = goalParent; s != 0; s = parents[s])
+            result.inputs += actionKeys[actions[s]];
+        std::reverse(result.inputs.begin(), result.inputs.end());
+        score(result);
+    }
+    else if(full)
+        result.note = "memory limit reached";
+    else
+        result.status = SOLVER_UNSOLVABLE;
+
+    for(int c = 0; c < chunks; c++)
+        delete sims[c];
+    sims.clear();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/*! \brief levelSolver::score
+ *  plays the inputs back to count block moves and steps taken where an enemy walks, and to check the way really
+ *  ends at a door. Difficulty grows with the length, the block work, the danger and how much had to be searched
+ */
+void levelSolver::score(solverResult &result) const{
+    simulation sim;
+    gameRandom random;
+    level.addTo(sim, false, random);
+    uint32_t items[8] = { 0 };
+    collect(sim, items);
+
+    bool done = false;
+    for(unsigned int i = 0; i < result.inputs.size(); i++){
+        bool carrying = sim.mjHasBlock();
+        apply(sim, result.inputs[i]);
+        collect(sim, items);
+        if(sim.mjHasBlock() != carrying)
+            result.blockMoves++;
+        for(unsigned int e = 0; e < enemies.size(); e++){
+            if(onRun(sim, enemies[e])){
+                result.exposure++;
+                break;
+            }
+        }
+        done = result.inputs[i] == 'S' && goal(sim, items);
+    }
+    if(!done)
+        result.note = "replay of the inputs did not end at a door";
+
+    result.difficulty = result.inputs.size() + 4.0*result.blockMoves + 3.0*result.exposure + 10.0*std::log10((double)result.states);
+}
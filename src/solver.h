@@ -0,0 +1,100 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "levelfile.h"
+#include "simulation.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//levels with more cells than this are not searched, the hash tables would not fit
+#define SOLVER_MAX_CELLS ( 1 << 22 )
+
+enum SolverStatus{
+    SOLVER_SOLVED,       //inputs holds a shortest way through
+    SOLVER_UNSOLVABLE,   //every reachable state was tried
+    SOLVER_UNKNOWN       //ran out of memory before either
+};
+
+struct solverResult{
+    SolverStatus status;
+    //A and D are the left and right keys, S is space
+    std::string inputs;
+    long long states;
+    int blockMoves;
+    int exposure;
+    double difficulty;
+    double seconds;
+    std::string note;
+};
+
+/* breadth first search over mj's position and facing, the block she carries, where the movable blocks are
+   and which items she has. Good guys and enemies are not simulated: a good guy hands over its item once mj
+   stands anywhere on the stretch of floor it walks, and enemies only add to the difficulty */
+class levelSolver
+{
+public:
+    levelSolver(const levelFile &level, int threads, long long memoryBytes);
+    solverResult solve();
+
+private:
+    struct npc{
+        int x;
+        int y;
+        int item;   //bit in the item mask, -1 for an enemy or a good guy that has nothing
+    };
+    struct chunkOut{
+        std::vector<uint32_t> states;
+        std::vector<uint64_t> hashes;
+        std::vector<uint32_t> parents;
+        std::vector<unsigned char> actions;
+        int goalParent;
+        unsigned char goalAction;
+    };
+
+    const levelFile &level;
+    int threads;
+    long long memoryBytes;
+
+    int width;
+    int cells;
+    int stride;
+    int itemWords;
+    uint32_t allItems[8];
+    std::vector<int> blockIds;
+    std::vector<npc> goods;
+    std::vector<npc> enemies;
+    std::vector<uint64_t> zobristMJ;
+    std::vector<uint64_t> zobristBlock;
+    uint64_t zobristFlags[8];
+    std::vector<uint64_t> zobristItem;
+
+    std::vector<simulation*> sims;
+    //packed states of the layer being expanded, layer[0] is state layerStart. Older layers only keep how they were reached
+    std::vector<uint32_t> layer;
+    std::vector<uint32_t> nextLayer;
+    int layerStart;
+    std::vector<uint32_t> parents;
+    std::vector<unsigned char> actions;
+    std::vector<uint64_t> visited;
+    uint64_t visitedMask;
+    long long visitedLimit;
+    long long visitedCount;
+
+    int cellOf(int x, int y) const { return y*width + x; }
+    bool inCells(const Entity &e) const { return e.x >= 0 && e.x < width && e.y >= 0 && cellOf(e.x, e.y) < cells; }
+    void encode(const simulation &sim, const uint32_t *items, uint32_t *out) const;
+    void decode(simulation &sim, const uint32_t *state) const;
+    uint64_t hash(const uint32_t *state) const;
+    bool onRun(const simulation &sim, const npc &n) const;
+    void collect(const simulation &sim, uint32_t *items) const;
+    bool hasAll(const uint32_t *items) const;
+    static void apply(simulation &sim, char action);
+    bool goal(const simulation &sim, const uint32_t *items) const;
+    void expand(int chunk, int begin, int end, chunkOut &out);
+    bool visit(uint64_t h);
+    bool seen(uint64_t h) const;
+    void score(solverResult &result) const;
+};
+
+#endif // SOLVER_H
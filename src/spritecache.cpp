@@ -0,0 +1,111 @@
+/*! \abstract spriteCache
+ *         The spriteCache turns sprite names into small integer ids and decodes each png the first time it is asked for.
+ *         Every widget showing the same sprite shares the same pixmap and brush afterwards, so moving things around or
+ *         reloading a level never goes back to the filesystem or the image decoder.
+ */
+
+#include "spritecache.h"
+#include "trace.h"
+#include "assets.h"
+
+spriteCache::spriteCache(){
+    decodes = 0;
+}
+
+/*! \brief spriteCache::canonicalName
+ *  level files say "woodfloor", items say "sprites/butter" and the editor says "sprites/woodfloor.png",
+ *  they all mean the same file
+ */
+QString spriteCache::canonicalName(const QString &name){
+    QString n = name.trimmed();
+    if(n.startsWith("sprites/"))
+        n = n.mid(8);
+    if(n.endsWith(".png"))
+        n.chop(4);
+    return n;
+}
+
+/*! \brief spriteCache::id
+ *  returns the id for a sprite name, a new name gets the next id but is not decoded yet. Every way of writing a
+ *  name is remembered, so the next time it is one lookup without trimming or cutting
+ */
+int spriteCache::id(const QString &name){
+    QHash<QString, int>::const_iterator it = ids.constFind(name);
+    if(it != ids.constEnd())
+        return it.value();
+
+    QString n = canonicalName(name);
+    it = ids.constFind(n);
+    if(it != ids.constEnd()){
+        int found = it.value();
+        ids.insert(name, found);
+        return found;
+    }
+
+    int newId = names.size();
+    ids.insert(n, newId);
+    if(name != n)
+        ids.insert(name, newId);
+    names.append(n);
+    pixmaps.append(QPixmap());
+    brushes.append(QBrush());
+    loaded.append(false);
+    return newId;
+}
+
+void spriteCache::load(int id){
+    TRACE_SCOPE("decode sprite");
+    pixmaps[id] = assets().pixmap("sprites/" + names.at(id) + ".png");
+    brushes[id] = QBrush(pixmaps.at(id));
+    loaded[id] = true;
+    decodes++;
+}
+
+const QPixmap& spriteCache::pixmap(int id){
+    if(!loaded.at(id))
+        load(id);
+    return pixmaps.at(id);
+}
+
+const QBrush& spriteCache::brush(int id){
+    if(!loaded.at(id))
+        load(id);
+    return brushes.at(id);
+}
+
+QString spriteCache::name(int id) const{
+    return names.at(id);
+}
+
+int spriteCache::count() const{
+    return names.size();
+}
+
+/*! \brief spriteCache::preload
+ *  takes a sprite that was decoded on another thread, unless it was loaded here in the meantime
+ */
+void spriteCache::preload(const QString &name, const QImage &image){
+    int i = id(name);
+    if(loaded.at(i))
+        return;
+    pixmaps[i] = QPixmap::fromImage(image);
+    brushes[i] = QBrush(pixmaps.at(i));
+    loaded[i] = true;
+    decodes++;
+}
+
+QSet<QString> spriteCache::decodedNames() const{
+    QSet<QString> decoded;
+    for(int i = 0; i < names.size(); i++){
+        if(loaded.at(i))
+            decoded.insert(names.at(i));
+    }
+    return decoded;
+}
+
+/*! \brief spriteCache::decodeCount
+ *  how many pngs were decoded so far, should stay at one per sprite
+ */
+int spriteCache::decodeCount() const{
+    return decodes;
+}
@@ -0,0 +1,36 @@
+#ifndef SPRITECACHE_H
+#define SPRITECACHE_H
+
+#include <QtCore>
+#include <QtGui>
+
+/* decodes every sprite once and hands out shared pixmaps and brushes by id */
+class spriteCache
+{
+public:
+    spriteCache();
+
+    int id(const QString &name);
+    const QPixmap& pixmap(int id);
+    const QBrush& brush(int id);
+    QString name(int id) const;
+    int count() const;
+    int decodeCount() const;
+    //a picture decoded somewhere else, see levelPrefetch
+    void preload(const QString &name, const QImage &image);
+    QSet<QString> decodedNames() const;
+
+    static QString canonicalName(const QString &name);
+
+private:
+    QHash<QString, int> ids;
+    QVector<QString> names;
+    QVector<QPixmap> pixmaps;
+    QVector<QBrush> brushes;
+    QVector<bool> loaded;
+    int decodes;
+
+    void load(int id);
+};
+
+#endif // SPRITECACHE_H
@@ -17,7 +17,7 @@ start::start(QWidget *parent) :
     this->setWindowFlags(Qt::FramelessWindowHint);
     player = new QMediaPlayer;
 
-    player->setMedia(QUrl::fromLocalFile(QFileInfo("sounds/afroman_because_i_got_high_instrumental.mp3").absoluteFilePath() ));
+    assets().setMedia(player, "sounds/afroman_because_i_got_high_instrumental.mp3");
     player->setVolume(50);
     player->play();
 }
@@ -52,7 +52,7 @@ void start::on_pushButton_clicked(){
     }
 
     gamewindow *mainWindow = new gamewindow(0, true, session);
-    mainWindow->setWindowIcon(QIcon("sprites/MJ_left.png"));
+    mainWindow->setWindowIcon(QIcon(assets().pixmap("sprites/MJ_left.png")));
     mainWindow->setWindowTitle(QString("Mary Jane's Baking Quest"));
 
     mainWindow->setCentralWidget( mainWindow->GetGraphicsView() );
@@ -87,7 +87,7 @@ void start::on_pushButton_2_clicked(){
 
     gamewindow *mainWindow = new gamewindow(0, false, session);
 
-    mainWindow->setWindowIcon(QIcon("sprites/MJ_left.png"));
+    mainWindow->setWindowIcon(QIcon(assets().pixmap("sprites/MJ_left.png")));
     mainWindow->setWindowTitle(QString("Mary Jane's Baking Quest"));
 
     mainWindow->setCentralWidget( mainWindow->GetGraphicsView() );
@@ -105,7 +105,7 @@ void start::on_pushButton_2_clicked(){
 void start::on_pushButton_3_clicked(){
     editWindow *mainWindow = new editWindow;
 
-    mainWindow->setWindowIcon(QIcon("sprites/mexican_man.png"));
+    mainWindow->setWindowIcon(QIcon(assets().pixmap("sprites/mexican_man.png")));
     mainWindow->setWindowTitle(QString("MJBQ Editor"));
 
     mainWindow->setCentralWidget( mainWindow->GetGraphicsView() );
@@ -127,7 +127,8 @@ void start::on_pushButton_4_clicked(){
     msgBox.setText("Press the 'D' key to move Mary Jane Forward.\n"
                    "Press the 'A' key to move Mary Jane Backward.\n"
                    "Press the space bar to pick up or drop blocks.\n"
-                   "Also press space bar when in front of a door to go through it.\n\n"
+                   "Also press space bar when in front of a door to go through it.\n"
+                   "Press Esc to pause and unpause the game.\n\n"
                    "P.S If you get stuck, the 'R' key will reset the level");
     msgBox.exec();
 
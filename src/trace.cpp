@@ -0,0 +1,127 @@
+/*! \abstract traceLog
+ *         Spans around the expensive parts of the game, parsing, decoding sprites, filling the scene, the phases of a
+ *         tick, saving and going from one level to the next, kept per thread so the game loop and the worker pool never
+ *         wait on each other to record one. The game writes the last few seconds out when a tick runs over its budget,
+ *         see gamewindow::step.
+ */
+
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+/* one thread's spans. Only that thread writes events and written, write() reads them and throws away what the
+   thread may have overwritten while it was copying */
+struct traceRing{
+    traceEvent events[TRACE_EVENTS];
+    std::atomic<uint64_t> written;
+    int id;
+    std::string name;
+};
+
+static std::mutex &registryLock(){
+    static std::mutex lock;
+    return lock;
+}
+
+//rings are never freed, the spans of a thread that ended stay in the trace
+static std::vector<traceRing*> &rings(){
+    static std::vector<traceRing*> all;
+    return all;
+}
+
+static traceRing *threadRing(){
+    static thread_local traceRing *ring = NULL;
+    if(ring == NULL){
+        ring = new traceRing();
+        ring->written = 0;
+        std::lock_guard<std::mutex> guard(registryLock());
+        ring->id = (int)rings().size() + 1;
+        ring->name = "thread " + std::to_string(ring->id);
+        rings().push_back(ring);
+    }
+    return ring;
+}
+
+int64_t traceLog::now(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void traceLog::span(const char *name, int64_t start, int64_t duration){
+    traceRing *ring = threadRing();
+    uint64_t n = ring->written.load(std::memory_order_relaxed);
+    traceEvent &e = ring->events[n % TRACE_EVENTS];
+    e.name = name;
+    e.start = start;
+    e.duration = duration;
+    ring->written.store(n + 1, std::memory_order_release);
+}
+
+void traceLog::nameThread(const char *name){
+    traceRing *ring = threadRing();
+    std::lock_guard<std::mutex> guard(registryLock());
+    ring->name = name;
+}
+
+//names are string literals, this is only in case one has a quote in it
+static std::string escaped(const std::string &text){
+    std::string out;
+    for(unsigned int i = 0; i < text.size(); i++){
+        if(text[i] == '"' || text[i] == '\\')
+            out += '\\';
+        out += text[i];
+    }
+    return out;
+}
+
+/*! \brief traceLog::write
+ *  complete events ("ph": "X") in microseconds, one tid per thread with its name as metadata
+ */
+bool traceLog::write(const std::string &fileName, int64_t window, std::string &error){
+    std::ofstream out(fileName.c_str());
+    if(!out){
+        error = fileName + ": can not write";
+        return false;
+    }
+
+    int64_t since = now() - window;
+    std::vector<traceEvent> copy;
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    out.precision(3);
+    out << std::fixed;
+    bool first = true;
+
+    std::lock_guard<std::mutex> guard(registryLock());
+    for(unsigned int r = 0; r < rings().size(); r++){
+        traceRing *ring = rings()[r];
+        uint64_t end = ring->written.load(std::memory_order_acquire);
+        uint64_t begin = end > TRACE_EVENTS ? end - TRACE_EVENTS : 0;
+        copy.clear();
+        for(uint64_t i = begin; i < end; i++)
+            copy.push_back(ring->events[i % TRACE_EVENTS]);
+        //the thread kept going while we copied, the slots it wrote to since are not what we think they are
+        uint64_t after = ring->written.load(std::memory_order_acquire);
+        uint64_t safe = after >= TRACE_EVENTS ? after - TRACE_EVENTS + 1 : 0;
+
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->id
+            << ", \"args\": {\"name\": \"" << escaped(ring->name) << "\"}}";
+        first = false;
+        for(uint64_t i = std::max(begin, safe); i < end; i++){
+            const traceEvent &e = copy[i - begin];
+            if(e.start + e.duration < since)
+                continue;
+            out << ",\n{\"name\": \"" << escaped(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->id
+                << ", \"ts\": " << e.start/1000.0 << ", \"dur\": " << e.duration/1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    if(!out){
+        error = fileName + ": can not write";
+        return false;
+    }
+    return true;
+}
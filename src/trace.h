@@ -0,0 +1,49 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <string>
+
+//events each thread keeps, older ones are overwritten
+#define TRACE_EVENTS ( 1 << 16 )
+
+/* one finished span. name has to outlive the trace, string literals do */
+struct traceEvent{
+    const char *name;
+    int64_t start;
+    int64_t duration;
+};
+
+/* spans from every thread that records them, written out in the Chrome trace event format that chrome://tracing
+   and Perfetto open. Each thread writes only to its own ring, so recording takes no lock: the first span a thread
+   records registers its ring, after that it is a clock read and a store */
+class traceLog
+{
+public:
+    //nanoseconds on the clock spans are measured with
+    static int64_t now();
+    static void span(const char *name, int64_t start, int64_t duration);
+    //names the calling thread in the trace
+    static void nameThread(const char *name);
+    //the spans that ended in the last window nanoseconds, from all threads
+    static bool write(const std::string &fileName, int64_t window, std::string &error);
+};
+
+/* records the rest of the block it is declared in as a span */
+class traceScope
+{
+public:
+    explicit traceScope(const char *name) : name(name), start(traceLog::now()) {}
+    ~traceScope() { traceLog::span(name, start, traceLog::now() - start); }
+
+private:
+    const char *name;
+    int64_t start;
+};
+
+//a name per line, so a block can hold more than one scope
+#define TRACE_JOIN(a, b) a##b
+#define TRACE_NAME(a, b) TRACE_JOIN(a, b)
+#define TRACE_SCOPE(name) traceScope TRACE_NAME(traceScope, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,87 @@
+/*! \abstract workerPool
+ *         A small thread pool for the simulation. run() hands jobs 0 .. jobs-1 to the pool threads and to the calling thread
+ *         and returns once every job is done. There is no queue: one run happens at a time, which is all the simulation needs.
+ */
+
+#include "workerpool.h"
+#include "trace.h"
+
+workerPool::workerPool(int threads){
+    current = 0;
+    jobCount = 0;
+    nextJob = 0;
+    busy = 0;
+    generation = 0;
+    quit = false;
+
+    //the calling thread works too
+    for(int t = 1; t < threads; t++)
+        workers.push_back(std::thread(&workerPool::work, this));
+}
+
+workerPool::~workerPool(){
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+    }
+    wake.notify_all();
+    for(unsigned int t = 0; t < workers.size(); t++)
+        workers[t].join();
+}
+
+/*! \brief workerPool::run
+ *  runs job(0) .. job(jobs - 1) spread over the threads, returns when all of them are done
+ */
+void workerPool::run(int jobs, const std::function<void(int)> &job){
+    if(workers.empty()){
+        for(int j = 0; j < jobs; j++)
+            job(j);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        current = &job;
+        jobCount = jobs;
+        nextJob = 0;
+        busy = (int)workers.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    takeJobs();
+
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [this]{ return busy == 0; });
+    current = 0;
+}
+
+void workerPool::takeJobs(){
+    for(int j = nextJob++; j < jobCount; j = nextJob++){
+        TRACE_SCOPE("pool job");
+        (*current)(j);
+    }
+}
+
+/*! \brief workerPool::work
+ *  what a pool thread does: sleep until there is a run, help with it, report back
+ */
+void workerPool::work(){
+    traceLog::nameThread("worker");
+    unsigned int seen = 0;
+    for(;;){
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [this, seen]{ return quit || generation != seen; });
+            if(quit)
+                return;
+            seen = generation;
+        }
+
+        takeJobs();
+
+        std::lock_guard<std::mutex> guard(lock);
+        if(--busy == 0)
+            done.notify_one();
+    }
+}
@@ -0,0 +1,40 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* a fixed set of threads that run numbered jobs. The jobs of one run are handed out one at a time
+   from a shared counter, so a thread that finishes early takes the next one instead of waiting */
+class workerPool
+{
+public:
+    workerPool(int threads);
+    ~workerPool();
+
+    //threads working on a run, counting the one that calls run()
+    int size() const { return (int)workers.size() + 1; }
+    void run(int jobs, const std::function<void(int)> &job);
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    const std::function<void(int)> *current;
+    int jobCount;
+    std::atomic<int> nextJob;
+    int busy;
+    unsigned int generation;
+    bool quit;
+
+    void work();
+    void takeJobs();
+};
+
+#endif // WORKERPOOL_H